@@ -0,0 +1,236 @@
+// Headless benchmarks of layout, hit testing, focus, hover and child churn on
+// synthetic element trees. No window is created, so no display is needed.
+//
+// usage: tims-gui-bench [max_elements]
+//   max_elements defaults to 1000000; pass less for a quicker run
+
+#include <GUI/GUI.hpp>
+
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <functional>
+#include <new>
+#include <random>
+#include <string>
+#include <vector>
+
+namespace {
+	std::atomic<std::size_t> allocations { 0 };
+}
+
+void* operator new(std::size_t size) {
+	++allocations;
+	if (void* p = std::malloc(size > 0 ? size : 1)) {
+		return p;
+	}
+	throw std::bad_alloc();
+}
+
+void operator delete(void* p) noexcept {
+	std::free(p);
+}
+
+void operator delete(void* p, std::size_t) noexcept {
+	std::free(p);
+}
+
+namespace {
+
+	using ui::Ref;
+	using ui::Element;
+
+	// width of the simulated screen
+	const vec2 screen_size = { 1000.0f, 800.0f };
+
+	// deeper chains would overflow the stack, since layout recurses
+	const std::size_t max_chain_depth = 2000;
+
+	// padding of each level of a chain, small enough that the deepest level
+	// still fits the screen, as content overflowing its parent is laid out twice
+	const float chain_padding = 0.2f;
+
+	std::mt19937 rng(12345);
+
+	// stands in for a ui::Text word, which can't be measured without a font
+	// texture and so without a display. Like a word, it can't be found or focused
+	struct Word : ui::InlineElement {
+		Word(float width) {
+			setSize({ width, 18.0f }, true);
+			disable();
+		}
+	};
+
+	struct Tree {
+		std::string name;
+		Ref<Element> container;
+		// elements to change, focus and churn
+		std::vector<Ref<Element>> leaves;
+	};
+
+	// runs `op` `count` times and prints the time and allocations per operation
+	void measure(const std::string& tree, std::size_t size, const std::string& name, std::size_t count, const std::function<void(std::size_t)>& op) {
+		std::size_t allocs_before = allocations;
+		auto start = std::chrono::steady_clock::now();
+		for (std::size_t i = 0; i < count; ++i) {
+			op(i);
+		}
+		auto end = std::chrono::steady_clock::now();
+		std::size_t allocs = allocations - allocs_before;
+
+		double ns = (double)std::chrono::duration_cast<std::chrono::nanoseconds>(end - start).count();
+		std::printf("%-8s %9zu  %-16s %14.1f ns/op %12.2f allocs/op\n",
+			tree.c_str(), size, name.c_str(), ns / (double)count, (double)allocs / (double)count);
+	}
+
+	float randomWidth() {
+		return std::uniform_real_distribution<float>(10.0f, 80.0f)(rng);
+	}
+
+	vec2 randomPoint(const Tree& tree) {
+		return {
+			std::uniform_real_distribution<float>(0.0f, tree.container->width())(rng),
+			std::uniform_real_distribution<float>(0.0f, tree.container->height())(rng)
+		};
+	}
+
+	const Ref<Element>& randomLeaf(const Tree& tree) {
+		return tree.leaves[std::uniform_int_distribution<std::size_t>(0, tree.leaves.size() - 1)(rng)];
+	}
+
+	// blocks nested inside one another
+	Tree buildChain(std::size_t size) {
+		Tree tree { "chain", ui::root().add<ui::BlockElement>(), {} };
+		Ref<Element> parent = tree.container;
+		for (std::size_t i = 1; i < size; ++i) {
+			parent = parent->add<ui::BlockElement>();
+			parent->setPadding(chain_padding);
+			parent->setMinHeight(2.0f);
+		}
+		tree.leaves.push_back(parent);
+		return tree;
+	}
+
+	// one container holding every element as a row
+	Tree buildFlat(std::size_t size) {
+		Tree tree { "flat", ui::root().add<ui::BlockElement>(), {} };
+		for (std::size_t i = 0; i < size; ++i) {
+			auto row = tree.container->add<ui::BlockElement>();
+			row->setMinHeight(20.0f);
+			tree.leaves.push_back(row);
+		}
+		return tree;
+	}
+
+	// sections of inline elements broken up by floats and blocks
+	Tree buildPage(std::size_t size) {
+		Tree tree { "page", ui::root().add<ui::BlockElement>(), {} };
+		Ref<Element> section;
+		for (std::size_t i = 0; i < size; ++i) {
+			if (i % 200 == 0) {
+				section = tree.container->add<ui::BlockElement>();
+				section->setPadding(5.0f);
+			}
+			if (i % 50 == 0) {
+				auto left = section->add<ui::LeftFloatingElement>();
+				left->setSize({ 120.0f, 80.0f }, true);
+				tree.leaves.push_back(left);
+			} else if (i % 75 == 0) {
+				auto right = section->add<ui::RightFloatingElement>();
+				right->setSize({ 90.0f, 140.0f }, true);
+				tree.leaves.push_back(right);
+			} else if (i % 97 == 0) {
+				auto block = section->add<ui::BlockElement>();
+				block->setMinHeight(10.0f);
+				tree.leaves.push_back(block);
+			} else {
+				tree.leaves.push_back(section->add<Word>(randomWidth()));
+			}
+		}
+		return tree;
+	}
+
+	// words and line breaks, as written by Element::write
+	Tree buildText(std::size_t size) {
+		Tree tree { "text", ui::root().add<ui::BlockElement>(), {} };
+		Ref<Element> paragraph;
+		for (std::size_t i = 0; i < size; ++i) {
+			if (i % 500 == 0) {
+				paragraph = tree.container->add<ui::BlockElement>();
+			} else if (i % 12 == 0) {
+				paragraph->writeLineBreak();
+			}
+			tree.leaves.push_back(paragraph->add<Word>(randomWidth()));
+		}
+		return tree;
+	}
+
+	void run(const std::string& name, std::size_t size, const std::function<Tree(std::size_t)>& build) {
+		Tree tree;
+		measure(name, size, "build", 1, [&](std::size_t) {
+			tree = build(size);
+		});
+
+		measure(name, size, "layout (full)", 1, [&](std::size_t) {
+			ui::updateLayout(screen_size);
+		});
+
+		measure(name, size, "layout (clean)", 100, [&](std::size_t) {
+			ui::updateLayout(screen_size);
+		});
+
+		measure(name, size, "layout (1 dirty)", 100, [&](std::size_t i) {
+			const Ref<Element>& leaf = randomLeaf(tree);
+			leaf->setMinWidth(i % 2 == 0 ? 30.0f : 40.0f);
+			ui::updateLayout(screen_size);
+		});
+
+		measure(name, size, "findElementAt", 10000, [&](std::size_t) {
+			ui::root().findElementAt(randomPoint(tree));
+		});
+
+		measure(name, size, "focusTo", 10000, [&](std::size_t) {
+			ui::getContext().focusTo(randomLeaf(tree));
+		});
+		ui::getContext().focusTo(ui::root().shared_from_this());
+
+		measure(name, size, "handleHover", 10000, [&](std::size_t) {
+			ui::getContext().handleHover(randomPoint(tree));
+		});
+		ui::getContext().handleHover({ -1.0f, -1.0f });
+
+		measure(name, size, "release+adopt", 10000, [&](std::size_t) {
+			const Ref<Element>& leaf = randomLeaf(tree);
+			if (auto parent = leaf->parent().lock()) {
+				parent->release(leaf);
+				parent->adopt(leaf);
+			}
+		});
+
+		measure(name, size, "clear", 1, [&](std::size_t) {
+			tree.leaves.clear();
+			tree.container->close();
+			tree.container = nullptr;
+		});
+	}
+
+} // namespace
+
+int main(int argc, char** argv) {
+	std::size_t max_elements = 1000000;
+	if (argc > 1) {
+		max_elements = std::strtoull(argv[1], nullptr, 10);
+	}
+
+	std::printf("%-8s %9s  %-16s %20s %22s\n", "tree", "elements", "benchmark", "time", "allocations");
+	for (std::size_t size = 1000; size <= max_elements; size *= 10) {
+		if (size / 10 < max_chain_depth) {
+			run("chain", std::min(size, max_chain_depth), buildChain);
+		}
+		run("flat", size, buildFlat);
+		run("page", size, buildPage);
+		run("text", size, buildText);
+	}
+	return 0;
+}
@@ -3,12 +3,16 @@
 #include "Element.hpp"
 #include "Transition.hpp"
 #include "TextEntry.hpp"
+#include <condition_variable>
 #include <map>
+#include <mutex>
+#include <thread>
 
 namespace ui {
 
 	struct Context {
 		Context();
+		~Context();
 
 		// creates the application window and initializes rendering
 		void init(unsigned width, unsigned height, std::string title, float _render_delay);
@@ -59,9 +63,14 @@ namespace ui {
 		void handleDrag();
 
 		// calls onMouseOut on last hovered element and its ancestors until common ancester
-		// is found with new element located at `pos`, it and its ancestors have onMouseOver called
+		// is found with new element located at `pos`, it and its ancestors have onMouseOver called.
+		// Nothing is looked up again while neither `pos` nor the layout changed
 		void handleHover(vec2 pos);
 
+		// have the next handleHover look up the element under the mouse even if nothing moved,
+		// such as after changing what an overridden hit() accepts
+		void invalidateHover();
+
 		// calls quit handler unless `force` is true
 		void handleQuit(bool force);
 
@@ -77,26 +86,32 @@ namespace ui {
 		// get the desired time between renders
 		float getRenderDelay();
 
-		// set the rendering context's displacement from the top left corner
-		void setViewOffset(vec2 offset);
+		// reset the rendering context to the full window, with no clipping
+		void resetView();
 
-		// get the rendering context's displacement from the top left corner
-		vec2 getViewOffset();
+		// have an area of the screen drawn again in the next frame, as when
+		// something drawn there is removed
+		void addDamage(const sf::FloatRect& rect);
 
-		// reset the rendering context to the full window and default position
-		void resetView();
+		// draw the parts of the screen which changed since the last frame and display them.
+		// If nothing changed, nothing is drawn or displayed and false is returned.
+		// With the render thread running, the frame is drawn and displayed there, and
+		// this returns once it is drawn, without waiting for it to be displayed
+		bool renderFrame();
 
-		// apply changes to the rendering context
-		void updateView();
+		// draw and display frames on a thread of their own, which takes over the window's
+		// OpenGL context, so that waiting for the display overlaps with the next frame
+		void startRenderThread();
 
-		// get the on-screen coordinates of the current rendering context
-		const sf::FloatRect& getClipRect();
+		// draw and display frames on the calling thread again
+		void stopRenderThread();
 
-		// set the clipping area
-		void setClipRect(const sf::FloatRect& rect);
+		// get the number of frames which were skipped because nothing changed
+		unsigned long long getSkippedFrames() const;
 
-		// shrink the clipping area to that which intersects with `rect`
-		void intersectClipRect(const sf::FloatRect& rect);
+		// returns true if something may change from one frame to the next without any
+		// input: transitions, dragging, or an element under the mouse with continuous hover
+		bool isAnimating() const;
 
 		// update the default screen size
 		void resize(int w, int h);
@@ -146,8 +161,9 @@ namespace ui {
 		// cached current program time
 		float program_time;
 
-		// the renderwindow to which all ui elements are drawn
-		sf::RenderWindow renderwindow;
+		// the renderwindow to which all ui elements are drawn. Like the canvas, it holds
+		// graphics resources which need a display, so it is only created when first used
+		std::unique_ptr<sf::RenderWindow> renderwindow;
 
 		// the element currently being dragged
 		Ref<Element> dragging_element;
@@ -158,6 +174,16 @@ namespace ui {
 		// the element currently being hovered over
 		Ref<Element> hover_element;
 
+		// what hover_element was found for: the mouse position, the root's geometry
+		// generation and the dragging element, which is excluded
+		bool hover_valid;
+		vec2 hover_pos;
+		std::uint64_t hover_generation;
+		const Element* hover_excluded;
+
+		// true if hover_element or an ancestor has continuous hover enabled
+		bool hover_continuous;
+
 		// the element currently in focus
 		Ref<Element> current_element;
 
@@ -191,11 +217,47 @@ namespace ui {
 		// callback function to be called when program is being closed, program continues if false is returned
 		std::function<bool()> quit_handler;
 
-		// portion of the screen currently being rendered to
-		sf::FloatRect clip_rect;
-
-		// translation of things being rendered
-		vec2 view_offset;
+		// a frame recorded by renderFrame, to be drawn and displayed
+		struct Frame {
+			// size of the screen, in pixels
+			sf::Vector2u size;
+			// areas of the screen to draw again, each recorded into the list of the same index.
+			// Lists past the number of regions keep their memory for reuse
+			std::vector<sf::FloatRect> regions;
+			std::vector<DrawList> lists;
+			// the highlight, drawn over the frame when shown
+			bool highlight = false;
+			sf::RectangleShape highlight_rect;
+		};
+		Frame frame;
+
+		// size of the screen in the last frame recorded
+		sf::Vector2u frame_size;
+
+		// draw the recorded frame's regions to the canvas, and the canvas and
+		// highlight to the window, without displaying it
+		void drawFrame();
+
+		// the last frame drawn, of which only the damaged areas are drawn again.
+		// Only used by the thread that draws, which creates it
+		std::unique_ptr<sf::RenderTexture> canvas;
+
+		// the thread which draws and displays frames, if running
+		std::thread render_thread;
+		std::mutex render_mutex;
+		std::condition_variable render_condition;
+		// true from when a frame is recorded until it is drawn
+		bool frame_pending;
+		bool render_stopping;
+
+		// areas of the screen to draw again, in screen coordinates
+		std::vector<sf::FloatRect> damage;
+
+		// true if the highlight was drawn in the last frame and must be drawn away
+		bool highlight_shown;
+
+		// number of frames skipped since nothing changed
+		unsigned long long skipped_frames;
 
 		// width of the program's window
 		int width;
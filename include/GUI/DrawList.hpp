@@ -0,0 +1,99 @@
+#pragma once
+
+#include <SFML/Graphics.hpp>
+
+#include "GUI/RoundedRectangle.hpp"
+
+#include <functional>
+#include <vector>
+
+namespace ui {
+
+	// the drawing of a frame, recorded in painter's order and then drawn with few draw calls.
+	// Untextured geometry shares batches, as does geometry using the same texture, as long as
+	// joining an earlier batch doesn't move it behind something it overlaps. Clipping and
+	// callbacks end the batches before them. Memory is kept from one frame to the next
+	struct DrawList {
+
+		DrawList();
+
+		// remove everything, and set the area of the target, which is the outermost clipping area
+		void clear(const sf::FloatRect& screen);
+
+		// add triangles, transformed by `states.transform` and using `states.texture`.
+		// Blend modes and shaders aren't recorded
+		void addTriangles(const sf::Vertex* vertices, std::size_t count, const sf::RenderStates& states);
+
+		// add a convex shape's fill and outline. Shape textures aren't recorded
+		void addShape(const sf::Shape& shape, const sf::RenderStates& states);
+
+		// add a rounded rectangle's fill and outline
+		void addShape(const RoundedRectangle& shape, const sf::RenderStates& states);
+
+		// add a sprite
+		void addSprite(const sf::Sprite& sprite, const sf::RenderStates& states);
+
+		// add drawing which can't be recorded, such as an sf::Text, to be called in order
+		void addCallback(std::function<void(sf::RenderTarget&)> callback);
+
+		// limit what follows, up to the matching popClip, to the intersection of the current
+		// clipping area and `rect`, in screen coordinates. Returns false and adds nothing if
+		// the intersection is empty, since nothing in it could be seen
+		bool pushClip(const sf::FloatRect& rect);
+
+		// return to the clipping area from before the last successful pushClip
+		void popClip();
+
+		// get the current clipping area, in screen coordinates
+		const sf::FloatRect& clipRect() const;
+
+		// get the number of draw calls made by draw(), excluding callbacks
+		std::size_t batchCount() const;
+
+		// draw everything recorded, limited to the area given to clear(). The target's
+		// view is left showing that area
+		void draw(sf::RenderTarget& target) const;
+
+	private:
+
+		struct Batch {
+			const sf::Texture* texture;
+			// triangles, in screen coordinates
+			std::vector<sf::Vertex> vertices;
+			// area covered by the vertices
+			sf::FloatRect bounds;
+		};
+
+		struct Command {
+			enum class Type {
+				Batch,
+				Clip,
+				Callback
+			};
+			Type type;
+			// index into m_batches, m_clips or m_callbacks
+			std::size_t index;
+		};
+
+		// find the batch for geometry with the given texture covering `bounds`,
+		// starting a new batch if no recent one can be joined
+		Batch& batchFor(const sf::Texture* texture, const sf::FloatRect& bounds);
+
+		// add the fill and outline of anything with getPointCount() and getPoint() making a
+		// convex polygon within `local`, with its transform already applied to `transform`
+		template<typename ShapeType>
+		void addConvex(const ShapeType& shape, sf::Color fill, sf::Color outline, float thickness, const sf::Transform& transform, const sf::FloatRect& local);
+
+		std::vector<Command> m_commands;
+		// batches in use are the first m_batchcount, the rest keep their memory for reuse
+		std::vector<Batch> m_batches;
+		std::size_t m_batchcount;
+		// clipping areas to switch to, in order
+		std::vector<sf::FloatRect> m_clips;
+		std::vector<std::function<void(sf::RenderTarget&)>> m_callbacks;
+
+		// nested clipping areas while recording, the screen first
+		std::vector<sf::FloatRect> m_clipstack;
+	};
+
+} // namespace ui
@@ -1,9 +1,12 @@
 #pragma once
 
+#include "GUI/DrawList.hpp"
+#include "GUI/Layout.hpp"
 #include "GUI/RoundedRectangle.hpp"
 
 #include <SFML/Graphics.hpp>
 #include <vector>
+#include <list>
 #include <functional>
 #include <memory>
 
@@ -14,80 +17,14 @@ namespace ui {
 
 	using Key = sf::Keyboard::Key;
 
-	// How an element is laid out and positioned relative to its parent and siblings
-	enum class LayoutStyle {
-
-		// positioned relative to parent according only to setPos()
-		Free,
-
-		// positioned on the same line as adjacent Inline elements
-		Inline,
-
-		// positioned on a unique line, and taking up the full width available
-		Block,
-
-		// positioned left of all inline elements
-		FloatLeft,
-
-		// positioned right of all inline elements
-		FloatRight
-	};
-
-	// How a free element is positioned relative to the parent
-	enum class PositionStyle {
-		// the element's position is left untouched
-		None,
-
-		OutsideBegin,
-
-		// the element is positioned left of the left edge
-		OutsideLeft = OutsideBegin,
-
-		// the element is positioned above the top edge
-		OutsideTop = OutsideBegin,
-
-		InsideBegin,
-
-		// the element is positioned inside the left edge
-		InsideLeft = InsideBegin,
-
-		// the element is positioned inside the top edge
-		InsideTop = InsideBegin,
-
-		// the element is positioned in the middle of the parent
-		Center,
-
-		InsideEnd,
-
-		// the element is positioned inside the right edge
-		InsideRight = InsideEnd,
-
-		// the element is positioned inside the bottom edge
-		InsideBottom = InsideEnd,
-
-		OutsideEnd,
-
-		// the element is positioned right of the right edge
-		OutsideRight = OutsideEnd,
-
-		// the element is positioned below the bottom edge
-		OutsideBottom = OutsideEnd,
-	};
-
-	// How an element's inline children are aligned horizontally
-	enum class ContentAlign {
-		// from the left edge
-		Left,
-
-		// from the right edge
-		Right,
-
-		// centered between the left and right edges
-		Center,
+	// converts between the layout engine's and SFML's vectors
+	inline vec2 toVec2(Float2 v) {
+		return { v.x, v.y };
+	}
 
-		// spaced to fill the entire line
-		Justify
-	};
+	inline Float2 toFloat2(vec2 v) {
+		return { v.x, v.y };
+	}
 
 	enum class TextStyle : uint32_t {
 		Regular = sf::Text::Text::Style::Regular,
@@ -100,7 +37,7 @@ namespace ui {
 	template<typename ElementType>
 	using Ref = std::shared_ptr<ElementType>;
 
-	struct Element : std::enable_shared_from_this<Element> {
+	struct Element : LayoutNode, std::enable_shared_from_this<Element> {
 
 		// default constructor
 		Element(LayoutStyle _display_style);
@@ -160,15 +97,20 @@ namespace ui {
 		// set the visibility of the element
 		Element& setVisible(bool _visible);
 
-		// returns true if the element is isVisible
-		bool isVisible() const;
-
 		// when true, limits rendering and input to within the bounding rectangle
 		Element& setClipping(bool _clipping);
 
 		// returns true if clipping is enabled
 		bool clipping() const;
 
+		// when true, the element and its children are drawn once into a texture, which is
+		// then drawn in their place until something inside changes. Suits static subtrees
+		// drawn with many shapes and texts. Partly transparent drawing may blend differently
+		Element& setCached(bool _cached);
+
+		// returns true if caching is enabled
+		bool cached() const;
+
 		// set the position (from paren't origin to top-left corner of the element)
 		Element& setPos(vec2 _pos);
 
@@ -181,12 +123,6 @@ namespace ui {
 		// get the position (top-left corner of the element)
 		vec2 pos() const;
 
-		// get the horizontal distance from the parent's origin to the left edge
-		float left() const;
-
-		// get the vertical distance from the parent's origin to the top edge
-		float top() const;
-
 		// set the size. Choosing force = true will set both the min and max size
 		Element& setSize(vec2 _size, bool force = false);
 
@@ -214,15 +150,6 @@ namespace ui {
 		// set the current size. Choosing force = true will set both the min and max width
 		Element& setWidth(float width, bool force = false);
 
-		// get the minimum width
-		float minWidth() const;
-
-		// get the maximum width
-		float maxWidth() const;
-
-		// get the current width
-		float width() const;
-
 		// set the minimum height
 		Element& setMinHeight(float height);
 
@@ -232,65 +159,9 @@ namespace ui {
 		// set the current height. Choosing force = true will set the both the min and max height.
 		Element& setHeight(float height, bool force = false);
 
-		// get the maximum height
-		float maxHeight() const;
-
-		// get the minimum height
-		float minHeight() const;
-
-		// get the current height
-		float height() const;
-
-		// called when the window changes size. Useful for size-dependent updates
-		// that should happen after the window resizes due to layout or other cause
-		virtual void onResize();
-
-		// set the display style
-		void setLayoutStyle(LayoutStyle style);
-
-		// get the display style
-		LayoutStyle layoutStyle() const;
-
 		// set the horizontal alignment style
 		Element& setContentAlign(ContentAlign style);
 
-		// get the horizontal alignment style
-		ContentAlign contentAlign() const;
-
-		// Set the horizontal position style, which only applies to Free elements
-		// Determines how the element is positioned relative to the edges of the parent
-		// spacing has no effect if Center is selected
-		void setXPositionStyle(PositionStyle style, float spacing = 0.0f);
-
-		// get the horizontal position style
-		PositionStyle xPositionStyle() const;
-
-		// get the spacing for the horizontal position style
-		float xPositionSpacing() const;
-
-		// Set the vertical position style, which only applies to Free elements
-		// Determines how the element is positioned relative to the edges of the parent
-		// spacing has no effect if Center is selected
-		void setYPositionStyle(PositionStyle style, float spacing = 0.0f);
-
-		// get the horizontal position style
-		PositionStyle yPositionStyle() const;
-
-		// get the spacing for the horizontal position style
-		float yPositionSpacing() const;
-
-		// set the padding; spacing between content and border
-		void setPadding(float _padding);
-
-		// get the padding; spacing between content and border
-		float padding() const;
-
-		// set the margin; spacing between other self and other elements
-		void setMargin(float _margin);
-
-		// get the margin; spacing between other self and other elements
-		float margin() const;
-
 		// get the background color
 		sf::Color backgroundColor() const;
 
@@ -315,9 +186,15 @@ namespace ui {
 		// set the border thickness
 		void setBorderThickness(float thickness);
 
-		// true if a test point (in local space, relative to the element's origin) intercepts the element
+		// true if a test point (in local space, relative to the element's origin) intercepts the element.
+		// Once its parent has many children, only points within the element's bounds are tested,
+		// unless hitExtendsBounds() returns true or ownBounds() is overridden to cover the hit area
 		virtual bool hit(vec2 testpos) const;
 
+		// true if hit() may accept points outside of the element's bounds, so that it is always
+		// tested when its parent has many children. False by default
+		virtual bool hitExtendsBounds() const;
+
 		// the mouse's position relative to the element
 		vec2 localMousePos() const;
 
@@ -384,14 +261,26 @@ namespace ui {
 		// true if the mouse is currently over top of the element
 		bool hovering() const;
 
-		// called when the mouse is over the element
+		// called when the mouse is over the element, in frames where the mouse moved or
+		// what's under it changed, and in every frame with continuous hover enabled
 		// if false is returned, call will propagate to the parent
 		virtual bool onHover();
 
-		// called when the mouse is over the element with another element being dragged
+		// called when the mouse is over the element with another element being dragged,
+		// in the same frames as onHover
 		// if false is returned, call will propagate to the parent
 		virtual bool onHoverWith(Ref<Element> element);
 
+		// have onHover and onHoverWith called in every frame while the mouse is over the
+		// element, even when nothing moved
+		Element& enableContinuousHover();
+
+		// have onHover and onHoverWith called only when the mouse moved or what's under it changed
+		Element& disableContinuousHover();
+
+		// returns true if onHover and onHoverWith are called in every frame
+		bool continuousHover() const;
+
 		// drop the element (via the point local_pos, in local coordinates) onto the element below it
 		void drop(vec2 local_pos);
 
@@ -427,24 +316,26 @@ namespace ui {
 		void write(const std::string& text, sf::Font& font, sf::Color color = sf::Color(0xFF), unsigned charsize = 15, TextStyle style = TextStyle::Regular);
 
 		// write a sequence of text
-		void write(const std::wstring& text, sf::Font& font, sf::Color color = sf::Color(0xFF), unsigned charsize = 15, TextStyle style = TextStyle::Regular);
-
-		// write a line break, causing inline elements to continue on a new line
-		void writeLineBreak(unsigned charsize = 15u);
+		virtual void write(const std::wstring& text, sf::Font& font, sf::Color color = sf::Color(0xFF), unsigned charsize = 15, TextStyle style = TextStyle::Regular);
 
 		// write a page break, causing all elements to continue on a new line
 		void writePageBreak(float height = 0.0f);
 
-		// write a tab
-		void writeTab(float width = 50.0f);
-
 		// add a new child element
 		template<typename ElementType, typename... ArgsT>
 		Ref<ElementType> add(ArgsT&&... args);
 
+		// add a new child element for each value in [first, last), constructing each from its value
+		template<typename ElementType, typename InputIt>
+		std::vector<Ref<ElementType>> addMany(InputIt first, InputIt last);
+
 		// adopt an existing child element
 		void adopt(Ref<Element> child);
 
+		// replace all children and white space with the given elements, in order.
+		// children not among `newchildren` are destroyed
+		void replaceChildren(const std::vector<Ref<Element>>& newchildren);
+
 		// remove and destroy a child element
 		void remove(Ref<Element> element);
 
@@ -470,94 +361,159 @@ namespace ui {
 		// render the element in front of its siblings, regardless of layout
 		void bringToFront();
 
-		// destroy all children
-		void clear();
+		// destroy all children and white space
+		virtual void clear();
 
 		// find the element at the given local coordinates, optionally excluding a given element and all its children
 		Ref<Element> findElementAt(vec2 _pos, Ref<Element> exclude = nullptr);
 
-		// render the element
-		virtual void render(sf::RenderWindow& renderwindow);
+		// record the element's drawing into the frame's draw list. `states` holds the translation
+		// to the element's top left corner. The default records the background and border
+		virtual void record(DrawList& list, sf::RenderStates states);
+
+		// draw what can't be recorded directly to the target. Only called for elements
+		// that ask for it in record() through recordRender. Draws nothing by default
+		virtual void render(sf::RenderTarget& target, sf::RenderStates states);
+
+		// elements used to draw themselves straight to the window here. Overriding it no
+		// longer compiles, since it would never be called: move the drawing into record(),
+		// or into render() above and call recordRender from record()
+		virtual void render(sf::RenderWindow& renderwindow) final = delete;
+
+		// have the element and its children drawn again in the next frame. The setters
+		// do this already. Call it after changing what a custom record() or render() draws
+		void repaint();
+
+	protected:
+
+		// have render() called at this point in the frame, which splits the draw list's batches
+		void recordRender(DrawList& list, sf::RenderStates states);
+
+		// the element's rectangle and border
+		Bounds ownBounds() const override;
+
+		// true while clipping
+		bool clipsDescendants() const override;
 
 	private:
 
 		Ref<Element> m_sharedthis;
 
-		LayoutStyle m_layoutstyle;
-		ContentAlign m_contentalign;
-
 		bool m_disabled;
-		bool m_visible;
 		bool m_clipping;
 
 		bool m_keyboard_navigable;
+		bool m_continuoushover;
 
-		vec2 m_pos;
-		vec2 m_size;
-		vec2 m_minsize;
-		vec2 m_maxsize;
-		vec2 m_oldtotalsize;
-
-		float m_layoutindex;
-		float m_padding;
-		float m_margin;
+		RoundedRectangle m_displayrect;
 
-		void updatePosition();
-		void updateChildPositions();
+		// children are added and removed along with the rendering order
+		using LayoutNode::appendChild;
+		using LayoutNode::removeChild;
 
-		PositionStyle m_pstyle_x, m_pstyle_y;
-		float m_spacing_x, m_spacing_y;
+		// record the element's children, translating and clipping as needed
+		void recordChildren(DrawList& list, sf::RenderStates states);
 
-		RoundedRectangle m_displayrect;
+		// record the element and its children, or their cached texture
+		void recordSubtree(DrawList& list, sf::RenderStates states);
 
-		void makeDirty();
-		bool isDirty() const;
-		void makeClean();
+		// the element and its children, drawn once with setCached
+		struct Cache {
+			sf::RenderTexture texture;
+			DrawList drawlist;
+			// position of the texture's top left corner relative to the element
+			vec2 origin;
+			// false when the texture must be drawn again
+			bool valid = false;
+		};
+		std::unique_ptr<Cache> m_cache;
 
-		bool m_isdirty;
+		// draw the element and its children into the cache's texture
+		bool updateCache();
 
-		using LayoutIndex = float;
+		// forget where the descendants were drawn, since it wasn't on the screen
+		void forgetDrawn();
 
-		// returns true if a change is needed
-		bool update(float width_avail);
+		// true if the element was drawn, and where it was, in screen coordinates,
+		// to know what must be drawn again when it changes
+		bool m_drawn;
+		sf::FloatRect m_drawnrect;
+		sf::FloatRect m_drawnarea;
 
-		// position and arrange children. Returns the actual size used
-		vec2 Element::arrangeChildren(float width_avail);
+		// true if the element looks different since it was last drawn
+		bool m_repaint;
 
-		// render the element's children, translating and clipping as needed
-		void renderChildren(sf::RenderWindow& renderwindow);
+		// adds the screen areas of the element and its changed descendants which must be
+		// drawn again, and forgets the changes. `origin` is the parent's screen position,
+		// and `covered` is true if the element's whole area is already included
+		void collectDamage(std::vector<sf::FloatRect>& damage, vec2 origin, bool covered);
 
-		LayoutIndex getNextLayoutIndex() const;
-		void organizeLayoutIndices();
+		// has the area the element was drawn in drawn again, without it
+		void eraseDrawn();
 
 		// returns true if this or an ancestor is in focus
 		bool ancestorInFocus() const;
 
-		struct WhiteSpace {
-
-			enum Type {
-				None,
-				LineBreak,
-				Tab
-			};
+		// children are found through an index once there are this many
+		static const std::size_t min_indexed_children = 32;
+		// limits on the index's columns and rows, and on the cells a child is listed in
+		static const std::size_t max_hit_cells = 65536;
+		static const std::size_t max_cells_per_child = 16;
 
-			WhiteSpace(Type _type, LayoutIndex _layout_index, unsigned _charsize = 15u);
+		struct HitEntry {
+			// 0 for the frontmost child
+			std::uint32_t order;
+			Element* element;
+		};
 
-			Type type;
-			LayoutIndex layout_index;
-			unsigned charsize;
+		// the visible, enabled children in a grid by the area covered by them and their
+		// descendants, for findElementAt. Built for one geometry generation
+		struct HitIndex {
+			std::uint64_t generation;
+			vec2 origin;
+			float cellsize;
+			std::size_t columns;
+			std::size_t rows;
+			// cell i holds entries[cellstart[i]] up to entries[cellstart[i + 1]], frontmost first
+			std::vector<std::uint32_t> cellstart;
+			std::vector<HitEntry> entries;
+			// children covering too many cells to list in each, or which may be hit outside of
+			// their bounds, frontmost first. These are tested wherever the point is
+			std::vector<HitEntry> large;
 		};
+		std::unique_ptr<HitIndex> m_hitindex;
 
-		std::vector<std::pair<Ref<Element>, WhiteSpace>> sortChildrenByLayoutIndex() const;
+		// get the index of the children, building it again if anything moved
+		const HitIndex& hitIndex();
 
 		std::weak_ptr<Element> m_parent;
-		std::vector<Ref<Element>> m_children;
-		std::vector<WhiteSpace> m_whitespaces;
+
+		// children in rendering order. Removed children leave an empty slot
+		// behind until enough have accumulated to be worth compacting
+		mutable std::vector<Ref<Element>> m_children;
+
+		// number of empty slots in `m_children`
+		mutable std::size_t m_emptychildslots;
+
+		// index of this element in the parent's `m_children`
+		std::size_t m_childslot;
+
+		// adds a child to the end of the rendering order and layout sequence
+		// without dirtying anything, so that batches only dirty once
+		void attachChild(const Ref<Element>& child);
+
+		// returns the child whose subtree contains the element in focus, if any
+		Ref<Element> childInFocus() const;
+
+		// removes a child from the rendering order and layout sequence
+		void detachChild(Element& child);
+
+		// removes empty slots from `m_children`
+		void compactChildren() const;
 
 		friend struct Context;
 		friend void run();
 		friend Element& root();
-		friend struct LayoutData;
 	};
 
 	struct FreeElement : Element {
@@ -580,6 +536,14 @@ namespace ui {
 		RightFloatingElement();
 	};
 
+	struct FlexElement : Element {
+		FlexElement(FlexDirection direction = FlexDirection::Row);
+	};
+
+	struct GridElement : Element {
+		GridElement(std::vector<GridTrack> columns = {});
+	};
+
 	template<typename ElementType, typename ...ArgsT>
 	inline Ref<ElementType> Element::add(ArgsT && ...args) {
 		static_assert(std::is_base_of<Element, ElementType>::value, "ElementType must derive from Element");
@@ -591,4 +555,19 @@ namespace ui {
 		return child;
 	}
 
+	template<typename ElementType, typename InputIt>
+	inline std::vector<Ref<ElementType>> Element::addMany(InputIt first, InputIt last) {
+		static_assert(std::is_base_of<Element, ElementType>::value, "ElementType must derive from Element");
+		std::vector<Ref<ElementType>> added;
+		for (; first != last; ++first) {
+			// see add() for why the child is created this way
+			auto rawchild = new ElementType(*first);
+			Ref<ElementType> child = rawchild->thisAs<ElementType>();
+			attachChild(child);
+			added.push_back(child);
+		}
+		childrenChanged();
+		return added;
+	}
+
 } // namespace ui
\ No newline at end of file
@@ -3,6 +3,7 @@
 #include <SFML/Main.hpp>
 #include "Element.hpp"
 #include "Text.hpp"
+#include "Paragraph.hpp"
 #include "TextEntry.hpp"
 #include "Context.hpp"
 #include "Image.hpp"
@@ -47,6 +48,22 @@ namespace ui {
 	// close the application
 	void quit(bool force = false);
 
+	// lay out the root element and everything in it to fit `size`,
+	// as is done every frame by run(). Needs no window
+	void updateLayout(vec2 size);
+
+	// returns true if the last layout ran out of its budget, set with
+	// setLayoutBudget, and will continue in the following frames
+	bool layoutPending();
+
+	// get the number of frames which weren't drawn because nothing on screen changed
+	unsigned long long skippedFrames();
+
+	// when true, run() draws and displays frames on a thread of their own, so that the
+	// next frame's input and layout are handled while waiting for the display. Elements
+	// are only left alone while a frame is drawn, which is short. Off by default
+	void setRenderThread(bool enabled);
+
 	// run the application
 	void run();
 
@@ -0,0 +1,24 @@
+#pragma once
+
+#include "GUI/Element.hpp"
+
+namespace ui {
+
+	// horizontal offset per unit of height for italic text, as used by sf::Text
+	const float italic_shear = 0.209f;
+
+	// returns true if `style` includes `flag`
+	bool hasStyle(TextStyle style, TextStyle flag);
+
+	// appends a glyph whose origin is at `baseline`, as two triangles
+	void appendGlyph(sf::VertexArray& vertices, sf::Color color, vec2 baseline, const sf::Glyph& glyph, float shear);
+
+	// appends a horizontal line, textured with the white pixels every font texture has at its corner
+	void appendLine(sf::VertexArray& vertices, sf::Color color, float left, float right, float y, float thickness);
+
+	// appends the glyphs of a string laid out as sf::Text does, with its top left at `origin`.
+	// They are textured with font.getTexture(charsize), so strings in the same font and size
+	// can share one draw call
+	void appendString(sf::VertexArray& vertices, const sf::String& string, const sf::Font& font, unsigned charsize, TextStyle style, sf::Color color, vec2 origin);
+
+} // namespace ui
@@ -8,5 +8,6 @@
 #include "GUI/helpers/Slider.hpp"
 #include "GUI/helpers/TextEntryHelper.hpp"
 #include "GUI/helpers/ToggleButton.hpp"
+#include "GUI/helpers/VirtualList.hpp"
 #include "GUI/helpers/NumberTextEntry.hpp"
 #include "GUI/helpers/pi.hpp"
\ No newline at end of file
@@ -46,7 +46,7 @@ namespace ui {
 
 		void onResize() override;
 
-		void render(sf::RenderWindow& rw) override;
+		void record(DrawList& list, sf::RenderStates states) override;
 
 		Ref<sf::Texture> texture;
 		sf::Sprite sprite;
@@ -0,0 +1,652 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <list>
+#include <memory>
+#include <vector>
+
+// the layout engine, which depends on nothing but the standard library
+// so that it can be built and used without SFML or a window
+
+namespace ui {
+
+	// a position or size, as used by the layout engine
+	struct Float2 {
+		Float2() : x(0.0f), y(0.0f) {
+
+		}
+
+		Float2(float _x, float _y) : x(_x), y(_y) {
+
+		}
+
+		Float2 operator+(Float2 other) const {
+			return { x + other.x, y + other.y };
+		}
+
+		Float2 operator-(Float2 other) const {
+			return { x - other.x, y - other.y };
+		}
+
+		Float2 operator*(float factor) const {
+			return { x * factor, y * factor };
+		}
+
+		Float2& operator+=(Float2 other) {
+			x += other.x;
+			y += other.y;
+			return *this;
+		}
+
+		Float2& operator-=(Float2 other) {
+			x -= other.x;
+			y -= other.y;
+			return *this;
+		}
+
+		float x, y;
+	};
+
+	// How an element is laid out and positioned relative to its parent and siblings
+	enum class LayoutStyle {
+
+		// positioned relative to parent according only to setPos()
+		Free,
+
+		// positioned on the same line as adjacent Inline elements
+		Inline,
+
+		// positioned on a unique line, and taking up the full width available
+		Block,
+
+		// positioned left of all inline elements
+		FloatLeft,
+
+		// positioned right of all inline elements
+		FloatRight,
+
+		// positioned like Block, with children arranged in rows or columns
+		// according to the flex properties instead of flowing as text
+		Flex,
+
+		// positioned like Block, with children arranged in the cells
+		// of a table of row and column tracks
+		Grid
+	};
+
+	// How a free element is positioned relative to the parent
+	enum class PositionStyle {
+		// the element's position is left untouched
+		None,
+
+		OutsideBegin,
+
+		// the element is positioned left of the left edge
+		OutsideLeft = OutsideBegin,
+
+		// the element is positioned above the top edge
+		OutsideTop = OutsideBegin,
+
+		InsideBegin,
+
+		// the element is positioned inside the left edge
+		InsideLeft = InsideBegin,
+
+		// the element is positioned inside the top edge
+		InsideTop = InsideBegin,
+
+		// the element is positioned in the middle of the parent
+		Center,
+
+		InsideEnd,
+
+		// the element is positioned inside the right edge
+		InsideRight = InsideEnd,
+
+		// the element is positioned inside the bottom edge
+		InsideBottom = InsideEnd,
+
+		OutsideEnd,
+
+		// the element is positioned right of the right edge
+		OutsideRight = OutsideEnd,
+
+		// the element is positioned below the bottom edge
+		OutsideBottom = OutsideEnd,
+	};
+
+	// How an element's inline children are aligned horizontally,
+	// or a Flex element's children along its main axis
+	enum class ContentAlign {
+		// from the left edge
+		Left,
+
+		// from the right edge
+		Right,
+
+		// centered between the left and right edges
+		Center,
+
+		// spaced to fill the entire line
+		Justify
+	};
+
+	// The main axis along which a Flex element arranges its children
+	enum class FlexDirection {
+		// left to right, wrapping onto rows below
+		Row,
+
+		// top to bottom, wrapping onto columns to the right
+		Column
+	};
+
+	// the size of a row or column of a Grid element
+	struct GridTrack {
+
+		enum Type {
+			// `value` in pixels
+			Fixed,
+			// a share, in proportion to `value`, of the space left by other tracks.
+			// Rows only have space left if the grid has a minimum height
+			Fraction,
+			// the size of the largest child in the track
+			Auto
+		};
+
+		GridTrack(Type _type = Auto, float _value = 0.0f);
+
+		Type type;
+		float value;
+	};
+
+	// an axis-aligned area, by its top left and bottom right corners
+	struct Bounds {
+		Float2 min;
+		Float2 max;
+	};
+
+	// a box laid out like an inline element without being a node, such as a word of a paragraph
+	struct InlineBox {
+		Float2 pos;
+		float width;
+		float height;
+		// space before whatever follows on the same line, such as a word's trailing
+		// space. It isn't part of the box, so it isn't fitted or aligned at a line's end
+		float advance;
+	};
+
+	// lay out independent subtrees, such as free and block elements, across
+	// `threads` worker threads. 0, the default, lays out on the calling thread.
+	// While laying out in parallel, onResize is deferred until the subtrees
+	// are joined, and must not be relied upon to run before the parent's layout
+	void setLayoutThreads(unsigned threads);
+
+	// limit each call to LayoutNode::layout() to about `microseconds`. Once the time
+	// is up, every dirty node not yet reached, even inside a subtree already started,
+	// keeps its previous height and the arrangement of its children, taking only the
+	// position and width its parent gives it, and is laid out by the following calls
+	// so that a large change is shown progressively. Each call finishes at least one
+	// node with children, and nodes without children are never skipped. This also holds
+	// for subtrees laid out on worker threads with setLayoutThreads(). 0, the default,
+	// lays out everything at once
+	void setLayoutBudget(unsigned microseconds);
+
+	// get the time allowed for each layout, in microseconds
+	unsigned layoutBudget();
+
+	// a box in the layout tree, which positions and sizes its children.
+	// ui::Element is a layout node; nodes may also be used on their own
+	// to lay out content headlessly
+	struct LayoutNode {
+
+		LayoutNode(LayoutStyle style);
+
+		// detaches the node from its parent and children
+		virtual ~LayoutNode();
+
+		LayoutNode(const LayoutNode&) = delete;
+		LayoutNode& operator=(const LayoutNode&) = delete;
+
+		// lay out the node and everything in it to fit `width_avail`
+		void layout(float width_avail);
+
+		// returns true if the node or its descendants still need to be laid out,
+		// such as after a layout ran out of its budget
+		bool layoutPending() const;
+
+		// get the area covered by the node and its visible descendants, relative to the
+		// node's top left corner. It is conservative, and only recomputed where something
+		// moved or changed size since the last call
+		Bounds subtreeBounds();
+
+		// mark the node's bounds as changed, such as after it starts drawing outside
+		// of what ownBounds() previously returned
+		void invalidateBounds();
+
+		// returns true if the node or a descendant moved, changed size or visibility,
+		// was laid out or was marked with markChanged() since clearChanges() was called
+		bool hasChanges() const;
+
+		// get a number which changes whenever the node or a descendant is laid out, moved,
+		// shown, hidden, added or removed, or otherwise changes where it can be found
+		std::uint64_t geometryGeneration() const;
+
+		// add a child node to the end of the layout sequence, removing it from any previous parent
+		void appendChild(LayoutNode& child);
+
+		// remove a child node from the layout sequence
+		void removeChild(LayoutNode& child);
+
+		// get the parent node, or nullptr if there is none
+		LayoutNode* layoutParent() const;
+
+		// set the visibility of the node
+		void setVisible(bool _visible);
+
+		// returns true if the node is visible
+		bool isVisible() const;
+
+		// set the position (from paren't origin to top-left corner of the node)
+		void setPos(Float2 _pos);
+
+		// set the horizontal distance from the parent's origin to left edge
+		void setLeft(float x);
+
+		// set the vertical distance from the parent's origin to the top edge
+		void setTop(float y);
+
+		// get the position (top-left corner of the node)
+		Float2 pos() const;
+
+		// get the horizontal distance from the parent's origin to the left edge
+		float left() const;
+
+		// get the vertical distance from the parent's origin to the top edge
+		float top() const;
+
+		// set the size. Choosing force = true will set both the min and max size
+		void setSize(Float2 _size, bool force = false);
+
+		// get the width and height of the node
+		Float2 size() const;
+
+		// set the maximum size
+		void setMaxSize(Float2 _max_size);
+
+		// set the minimum size
+		void setMinSize(Float2 _min_size);
+
+		// get the maximum size
+		Float2 maxSize() const;
+
+		// get the minimum size
+		Float2 minSize() const;
+
+		// set the minimum width
+		void setMinWidth(float width);
+
+		// set the maximum width
+		void setMaxWidth(float width);
+
+		// set the current size. Choosing force = true will set both the min and max width
+		void setWidth(float width, bool force = false);
+
+		// get the minimum width
+		float minWidth() const;
+
+		// get the maximum width
+		float maxWidth() const;
+
+		// get the current width
+		float width() const;
+
+		// set the minimum height
+		void setMinHeight(float height);
+
+		// set the maximum height
+		void setMaxHeight(float height);
+
+		// set the current height. Choosing force = true will set the both the min and max height.
+		void setHeight(float height, bool force = false);
+
+		// get the maximum height
+		float maxHeight() const;
+
+		// get the minimum height
+		float minHeight() const;
+
+		// get the current height
+		float height() const;
+
+		// called when the window changes size. Useful for size-dependent updates
+		// that should happen after the window resizes due to layout or other cause
+		virtual void onResize();
+
+		// set the display style
+		void setLayoutStyle(LayoutStyle style);
+
+		// get the display style
+		LayoutStyle layoutStyle() const;
+
+		// set the horizontal alignment style
+		void setContentAlign(ContentAlign style);
+
+		// get the horizontal alignment style
+		ContentAlign contentAlign() const;
+
+		// Set the horizontal position style, which only applies to Free nodes
+		// Determines how the node is positioned relative to the edges of the parent
+		// spacing has no effect if Center is selected
+		void setXPositionStyle(PositionStyle style, float spacing = 0.0f);
+
+		// get the horizontal position style
+		PositionStyle xPositionStyle() const;
+
+		// get the spacing for the horizontal position style
+		float xPositionSpacing() const;
+
+		// Set the vertical position style, which only applies to Free nodes
+		// Determines how the node is positioned relative to the edges of the parent
+		// spacing has no effect if Center is selected
+		void setYPositionStyle(PositionStyle style, float spacing = 0.0f);
+
+		// get the horizontal position style
+		PositionStyle yPositionStyle() const;
+
+		// get the spacing for the horizontal position style
+		float yPositionSpacing() const;
+
+		// set the padding; spacing between content and border
+		void setPadding(float _padding);
+
+		// get the padding; spacing between content and border
+		float padding() const;
+
+		// set the margin; spacing between other self and other nodes
+		void setMargin(float _margin);
+
+		// get the margin; spacing between other self and other nodes
+		float margin() const;
+
+		// set the direction in which a Flex node arranges its children
+		void setFlexDirection(FlexDirection direction);
+
+		// get the direction in which a Flex node arranges its children
+		FlexDirection flexDirection() const;
+
+		// set whether a Flex node starts a new row or column when its children don't fit.
+		// Columns only wrap if the maximum height is set
+		void setFlexWrap(bool wrap);
+
+		// returns true if a Flex node wraps its children
+		bool flexWrap() const;
+
+		// set the space between the children of a Flex node, and between its rows or columns
+		void setFlexGap(float gap);
+
+		// get the space between the children of a Flex node
+		float flexGap() const;
+
+		// set the share of free space given to this node by its Flex parent.
+		// Free space along columns only exists if the parent has a minimum height
+		void setFlexGrow(float grow);
+
+		// get the share of free space given to this node by its Flex parent
+		float flexGrow() const;
+
+		// set how much this node shrinks, relative to its size, when its Flex parent overflows
+		void setFlexShrink(float shrink);
+
+		// get how much this node shrinks when its Flex parent overflows
+		float flexShrink() const;
+
+		// set the columns of a Grid node. Without any, a grid has one Fraction column
+		void setGridColumns(std::vector<GridTrack> columns);
+
+		// get the columns of a Grid node
+		const std::vector<GridTrack>& gridColumns() const;
+
+		// set the rows of a Grid node. Rows are added as Auto tracks as children need them
+		void setGridRows(std::vector<GridTrack> rows);
+
+		// get the rows of a Grid node
+		const std::vector<GridTrack>& gridRows() const;
+
+		// set the space between the rows and columns of a Grid node
+		void setGridGap(float gap);
+
+		// get the space between the rows and columns of a Grid node
+		float gridGap() const;
+
+		// get the sizes of the columns of a Grid node, as last laid out
+		const std::vector<float>& gridColumnSizes() const;
+
+		// get the sizes of the rows of a Grid node, as last laid out
+		const std::vector<float>& gridRowSizes() const;
+
+		// place this node in a cell of its Grid parent. Cells spanning several tracks
+		// don't affect the size of Auto tracks, except that the last row spanned
+		// grows to fit. Nodes not placed fill the first free cells in order
+		void setGridCell(unsigned row, unsigned column, unsigned row_span = 1, unsigned column_span = 1);
+
+		// let the Grid parent place this node in the first free cell
+		void clearGridCell();
+
+		// write a line break, causing inline children to continue on a new line
+		void writeLineBreak(unsigned charsize = 15u);
+
+		// write a tab
+		void writeTab(float width = 50.0f);
+
+	protected:
+
+		// position and arrange children. Returns the actual size used
+		virtual Float2 arrangeChildren(float width_avail);
+
+		// position and arrange children without consulting the layout cache
+		Float2 layoutChildren(float width_avail);
+
+		// returns the boxes of a run of text written as a Text white space, which
+		// are laid out in order like inline children, and sets `count` to their number
+		virtual InlineBox* inlineBoxes(std::size_t run, std::size_t& count);
+
+		void updatePosition();
+		void updateChildPositions();
+
+		void makeDirty();
+		bool isDirty() const;
+		void makeClean();
+
+		// marks all ancestors as having a dirty descendant, so that update()
+		// knows which subtrees need to be visited
+		void makeAncestorsSubtreeDirty();
+
+		// dirties the node and, if it affects layout, its parent after children were changed,
+		// and gives it a new geometry generation. Called once after a batch of changes
+		void childrenChanged();
+
+		// returns true if a change is needed
+		bool update(float width_avail);
+
+		// get the area the node itself covers, relative to its top left corner.
+		// By default, its own rectangle
+		virtual Bounds ownBounds() const;
+
+		// returns true if descendants can only be seen within the node's own rectangle
+		virtual bool clipsDescendants() const;
+
+		// mark the node as changed, and its ancestors as having changed descendants
+		void markChanged();
+
+		// forget the changes to this node, but not to its descendants
+		void clearChanges();
+
+		// give the node and its ancestors a new geometry generation
+		void invalidateGeometry();
+
+		// true if the node takes up all of the width its parent gives it
+		bool fillsWidth() const;
+
+		// move the node while its parent lays it out. Only the node itself is marked as
+		// changed, since its siblings may be placed on other threads. The ancestors are
+		// marked by update() and layout() on their way out
+		void place(Float2 _pos);
+
+		// true if the node's Flex or Grid parent assigned it a size
+		bool hasAssignedSize() const;
+
+		struct WhiteSpace {
+
+			enum Type {
+				None,
+				LineBreak,
+				Tab,
+				// a run of text, whose boxes are given by inlineBoxes()
+				Text
+			};
+
+			WhiteSpace(Type _type, unsigned _charsize = 15u, std::size_t _run = 0);
+
+			Type type;
+			unsigned charsize;
+			// for text, the index of the run
+			std::size_t run;
+		};
+
+		// a child node or, if `node` is null, a white space or run of text
+		struct LayoutItem {
+			LayoutNode* node;
+			WhiteSpace space;
+		};
+
+		LayoutStyle m_layoutstyle;
+		ContentAlign m_contentalign;
+
+		bool m_visible;
+
+		Float2 m_pos;
+		Float2 m_size;
+		Float2 m_minsize;
+		Float2 m_maxsize;
+		Float2 m_oldtotalsize;
+
+		float m_padding;
+		float m_margin;
+
+		PositionStyle m_pstyle_x, m_pstyle_y;
+		float m_spacing_x, m_spacing_y;
+
+		// true if the node needs to be laid out again
+		bool m_isdirty;
+
+		// true if any descendant needs to be laid out again
+		bool m_subtreedirty;
+
+		// the available width most recently passed to update()
+		float m_widthavail;
+
+		// the area covered by the node and its descendants, valid unless m_boundsdirty
+		Bounds m_subtreebounds;
+
+		// true if the bounds of the node or a descendant changed. Every
+		// ancestor of a node with changed bounds is marked too
+		bool m_boundsdirty;
+
+		// true if the node or a descendant changed since clearChanges(), marked like m_boundsdirty
+		bool m_changed;
+
+		// true if the node was laid out again since clearChanges()
+		bool m_relaidout;
+
+		// the newest geometry generation of the node and its descendants
+		std::uint64_t m_geometrygeneration;
+
+		FlexDirection m_flexdirection;
+		bool m_flexwrap;
+		float m_flexgap;
+		float m_flexgrow;
+		float m_flexshrink;
+
+		// the size along its main axis which a Flex parent, or the width which
+		// a Grid parent, last assigned, or negative if left at its natural size
+		float m_assignedsize;
+
+		// the tracks of a Grid node and their sizes, which are only allocated for grids
+		struct GridData {
+			std::vector<GridTrack> columns;
+			std::vector<GridTrack> rows;
+			float gap = 0.0f;
+			std::vector<float> column_sizes;
+			std::vector<float> row_sizes;
+		};
+		std::unique_ptr<GridData> m_grid;
+
+		// gets the grid tracks, allocating them if needed
+		GridData& grid();
+
+		// the cell of a Grid parent this node was placed in
+		struct GridCell {
+			unsigned row = 0;
+			unsigned column = 0;
+			unsigned row_span = 1;
+			unsigned column_span = 1;
+			bool placed = false;
+		};
+		GridCell m_gridcell;
+
+		// natural size measured for a Flex parent or an Auto column of a Grid parent, which is
+		// reused while the node's generation and the width it was measured in stay the same
+		struct MeasuredSize {
+			Float2 size = Float2(-1.0f, -1.0f);
+			float width_avail = 0.0f;
+			unsigned generation = 0;
+		};
+		MeasuredSize m_measuredsize;
+
+		// incremented whenever something other than the available width affects
+		// the arrangement of children, which invalidates all cached layouts
+		unsigned m_layoutgeneration;
+
+		// the node whose layout sequence this node is in
+		LayoutNode* m_layoutparent;
+
+		// children and white spaces, always in layout order
+		std::list<LayoutItem> m_layoutsequence;
+
+		// position of this node in the parent's layout sequence
+		std::list<LayoutItem>::iterator m_layoutslot;
+
+	private:
+
+		struct CachedChildLayout {
+			const LayoutNode* child;
+			bool laid_out;
+			Float2 pos;
+			// the size including margins, which are also what the child is arranged by
+			Float2 outersize;
+			float width_avail;
+			float assignedsize;
+		};
+
+		struct CachedLayout {
+			float width_avail;
+			unsigned generation;
+			Float2 contentsize;
+			std::vector<CachedChildLayout> children;
+		};
+
+		// most recently used layouts, keyed by available width and generation
+		std::vector<CachedLayout> m_layoutcache;
+
+		// restores the children to a previously computed layout for the given width.
+		// returns false if no valid layout was cached
+		bool restoreCachedLayout(float width_avail, Float2& contentsize);
+
+		// stores the current arrangement of children
+		void cacheLayout(float width_avail, Float2 contentsize);
+
+		friend struct LayoutData;
+	};
+
+} // namespace ui
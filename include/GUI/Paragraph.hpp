@@ -0,0 +1,71 @@
+#pragma once
+
+#include "GUI/Element.hpp"
+
+namespace ui {
+
+	// an element holding text that is broken into lines by the paragraph itself,
+	// rather than as one ui::Text element per word. Text written to a paragraph
+	// flows around its floating children and between its inline children
+	struct Paragraph : Element {
+
+		Paragraph(LayoutStyle style = LayoutStyle::Block);
+
+		using Element::write;
+
+		// write a sequence of text as runs in the paragraph
+		void write(const std::wstring& text, sf::Font& font, sf::Color color = sf::Color(0xFF), unsigned charsize = 15, TextStyle style = TextStyle::Regular) override;
+
+		// destroy all text, children and white space
+		void clear() override;
+
+		void record(DrawList& list, sf::RenderStates states) override;
+
+	protected:
+
+		// lays out without the layout cache, since words are positioned too
+		Float2 arrangeChildren(float width_avail) override;
+
+		// the boxes of a run's words, which the layout positions
+		InlineBox* inlineBoxes(std::size_t run, std::size_t& count) override;
+
+	private:
+
+		// text written at once in one style, up to a line break or tab
+		struct Run {
+			const sf::Font* font;
+			sf::Color color;
+			unsigned charsize;
+			TextStyle style;
+			// distance between lines of this run
+			float height;
+			std::wstring text;
+			// the run's words in `m_words` and `m_boxes`
+			std::size_t first_word;
+			std::size_t word_count;
+		};
+
+		// a word within a run's text
+		struct Word {
+			std::size_t begin;
+			std::size_t length;
+		};
+
+		// glyphs of all runs sharing a font texture
+		struct GlyphBatch {
+			const sf::Texture* texture;
+			sf::VertexArray vertices;
+		};
+
+		// rebuilds the glyph vertices after the words have moved
+		void updateGeometry();
+
+		std::vector<Run> m_runs;
+		std::vector<Word> m_words;
+		// where each word was laid out. Advances are the following space, if any
+		std::vector<InlineBox> m_boxes;
+		std::vector<GlyphBatch> m_glyphs;
+		bool m_geometrydirty;
+	};
+
+} // namespace ui
@@ -2,16 +2,55 @@
 
 #include "SFML/Graphics.hpp"
 
+#include <algorithm>
+#include <array>
+#include <cmath>
+#include <vector>
+
 namespace ui {
 
-	struct RoundedRectangle : sf::ConvexShape {
-		RoundedRectangle(sf::Vector2f _size = {}, float _radius = 0.0f) : radius(_radius), size(_size) {
+	// a rectangle with rounded corners, drawn with DrawList::addShape. Its points are generated
+	// on request from shared tables of quarter circles, with fewer points for smaller corners,
+	// so no trigonometry is done and no vertices are kept per rectangle. Square corners need
+	// only four points
+	struct RoundedRectangle {
+		RoundedRectangle(sf::Vector2f _size = {}, float _radius = 0.0f)
+			: radius(std::max(_radius, 0.0f)), size(_size), corner_radius(0.0f), corner(nullptr),
+			fill_color(sf::Color::White), outline_color(sf::Color::White), outline_thickness(0.0f) {
+			updatePoints();
+		}
+
+		void setFillColor(sf::Color color) {
+			fill_color = color;
+		}
+
+		sf::Color getFillColor() const {
+			return fill_color;
+		}
 
+		void setOutlineColor(sf::Color color) {
+			outline_color = color;
+		}
+
+		sf::Color getOutlineColor() const {
+			return outline_color;
+		}
+
+		// the outline is drawn outside the rectangle
+		void setOutlineThickness(float thickness) {
+			outline_thickness = thickness;
+		}
+
+		float getOutlineThickness() const {
+			return outline_thickness;
 		}
 
 		void setRadius(float _radius) {
-			radius = std::max(_radius, 0.0f);
-			updatePoints();
+			_radius = std::max(_radius, 0.0f);
+			if (_radius != radius) {
+				radius = _radius;
+				updatePoints();
+			}
 		}
 
 		float getRadius() const {
@@ -19,78 +58,104 @@ namespace ui {
 		}
 
 		void setSize(sf::Vector2f _size) {
-			size = { std::max(_size.x, 0.0f), std::max(_size.y, 0.0f) };
-			updatePoints();
+			_size = { std::max(_size.x, 0.0f), std::max(_size.y, 0.0f) };
+			if (_size != size) {
+				size = _size;
+				updatePoints();
+			}
 		}
 
 		sf::Vector2f getSize() const {
 			return size;
 		}
 
+		// the area covered by the points
+		sf::FloatRect getLocalBounds() const {
+			return { 0.0f, 0.0f, size.x, size.y };
+		}
+
+		std::size_t getPointCount() const {
+			return corner ? 4 * corner->size() : 4;
+		}
+
+		sf::Vector2f getPoint(std::size_t index) const {
+			if (!corner) {
+				switch (index) {
+					default:
+					case 0: return { 0.0f, 0.0f };
+					case 1: return { size.x, 0.0f };
+					case 2: return { size.x, size.y };
+					case 3: return { 0.0f, size.y };
+				}
+			}
+
+			// each corner goes a quarter turn clockwise, starting from the top left
+			const float r = corner_radius;
+			const sf::Vector2f& u = (*corner)[index % corner->size()];
+			switch (index / corner->size()) {
+				default:
+				case 0: return { r * (1.0f - u.x), r * (1.0f - u.y) };
+				case 1: return { size.x - r + r * u.y, r * (1.0f - u.x) };
+				case 2: return { size.x - r + r * u.x, size.y - r + r * u.y };
+				case 3: return { r * (1.0f - u.y), size.y - r + r * u.x };
+			}
+		}
+
 	private:
 		float radius;
 		sf::Vector2f size;
 
+		// the radius used, which is limited by the size
+		float corner_radius;
 
-		void updatePoints() {
+		// cosines and sines from 0 to a quarter turn, or null for square corners
+		const std::vector<sf::Vector2f>* corner;
+
+		sf::Color fill_color;
+		sf::Color outline_color;
+		float outline_thickness;
+
+		// quarter circles with 1, 2, 4 ... 64 segments, and the largest radius each suits
+		struct CornerTable {
+			float max_radius;
 			std::vector<sf::Vector2f> points;
+		};
+		static const std::size_t corner_levels = 7;
+
+		static const std::array<CornerTable, corner_levels>& cornerTables() {
+			static const std::array<CornerTable, corner_levels> tables = [] {
+				// corners stray at most this far from a true circle, in pixels
+				const float max_error = 0.25f;
+				const double pi = 3.14159265358979;
+				std::array<CornerTable, corner_levels> t;
+				for (std::size_t level = 0; level < corner_levels; ++level) {
+					std::size_t segments = std::size_t(1) << level;
+					double step = pi * 0.5 / (double)segments;
+					// a segment strays from its arc by r * (1 - cos(step / 2)) at most
+					t[level].max_radius = max_error / (float)(1.0 - std::cos(step * 0.5));
+					for (std::size_t i = 0; i <= segments; ++i) {
+						t[level].points.push_back({ (float)std::cos(step * (double)i), (float)std::sin(step * (double)i) });
+					}
+				}
+				return t;
+			}();
+			return tables;
+		}
 
-			const float rad = std::min(radius, std::min(size.x * 0.5f, size.y * 0.5f));
-			if (rad == 0.0f) {
-				points.push_back({ 0.0f, 0.0f });
-				points.push_back({ size.x, 0.0f });
-				points.push_back({ size.x, size.y });
-				points.push_back({ 0.0f, size.y });
+		void updatePoints() {
+			corner_radius = std::min(radius, std::min(size.x * 0.5f, size.y * 0.5f));
+			if (corner_radius == 0.0f) {
+				corner = nullptr;
 			} else {
-				const float pi = 3.141592654f;
-				float inc = pi / rad;
-
-				// top left corner
-				for (float a = 0.0; a < pi * 0.5f; a += inc) {
-					sf::Vector2f pos {
-						rad * (1.0f - cos(a)),
-						rad * (1.0f - sin(a))
-					};
-					points.push_back(pos);
-				}
-				points.push_back({ rad, 0.0f });
-
-				// top right corner
-				for (float a = 0.0f; a < pi * 0.5f; a += inc) {
-					sf::Vector2f pos {
-						size.x + rad * (-1.0f + sin(a)),
-						rad * (1.0f - cos(a))
-					};
-					points.push_back(pos);
+				// the fewest segments which look round at this radius
+				const auto& tables = cornerTables();
+				std::size_t level = 0;
+				while (level + 1 < corner_levels && corner_radius > tables[level].max_radius) {
+					++level;
 				}
-				points.push_back({ size.x, rad });
-
-				// bottom right corner
-				for (float a = 0.0f; a < pi * 0.5f; a += inc) {
-					sf::Vector2f pos {
-						size.x + rad * (-1.0f + cos(a)),
-						size.y + rad * (-1.0f + sin(a))
-					};
-					points.push_back(pos);
-				}
-				points.push_back({ size.x - rad, size.y });
-
-				// bottom left corner
-				for (float a = 0.0f; a < pi * 0.5f; a += inc) {
-					sf::Vector2f pos {
-						rad * (1.0f - sin(a)),
-						size.y + rad * (-1.0f + cos(a))
-					};
-					points.push_back(pos);
-				}
-				points.push_back({ 0.0f, size.y - rad });
-			}
-
-			setPointCount(points.size());
-			for (std::size_t i = 0; i < points.size(); ++i) {
-				setPoint(i, points[i]);
+				corner = &tables[level].points;
 			}
 		}
 	};
 
-} // namespace ui
\ No newline at end of file
+} // namespace ui
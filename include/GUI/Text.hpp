@@ -23,13 +23,22 @@ namespace ui {
 		void setStyle(TextStyle style);
 		TextStyle getStyle() const;
 
-		void render(sf::RenderWindow& renderwin) override;
+		// records the glyphs as triangles using the font's texture, so that texts
+		// in the same font and size are drawn together
+		void record(DrawList& list, sf::RenderStates states) override;
 
 	protected:
 
 		void updateSize();
 
+		// sf::Text is kept for measuring, but never drawn
 		sf::Text text;
+
+	private:
+
+		// the glyphs of `text`, made again when it changes
+		sf::VertexArray glyphs;
+		bool glyphs_dirty;
 	};
 
 }
\ No newline at end of file
@@ -18,7 +18,8 @@ namespace ui {
 		virtual void onReturn(std::wstring entered_text);
 		virtual void onType(std::wstring full_text);
 
-		void render(sf::RenderWindow& renderwindow) override;
+		// records the text, and the cursor while typing
+		void record(DrawList& list, sf::RenderStates states) override;
 
 		bool onKeyDown(Key key) override;
 		bool onLeftClick(int clicks) override;
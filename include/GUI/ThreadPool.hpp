@@ -0,0 +1,83 @@
+#pragma once
+
+#include <atomic>
+#include <condition_variable>
+#include <deque>
+#include <exception>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace ui {
+
+	// a fixed set of worker threads, each with its own queue of tasks from which
+	// idle workers steal. Tasks are run in groups, and waiting on a group runs
+	// pending tasks on the waiting thread, so that tasks may themselves fork and
+	// wait on nested groups without deadlocking
+	struct ThreadPool {
+
+		// a set of tasks that can be waited on together
+		struct TaskGroup {
+			TaskGroup();
+
+		private:
+			std::atomic<std::size_t> pending;
+			std::exception_ptr exception;
+			std::mutex exception_mutex;
+
+			friend struct ThreadPool;
+		};
+
+		// starts `threads` worker threads
+		ThreadPool(unsigned threads);
+
+		// finishes all queued tasks and joins the worker threads
+		~ThreadPool();
+
+		ThreadPool(const ThreadPool&) = delete;
+		ThreadPool& operator=(const ThreadPool&) = delete;
+
+		// the number of worker threads
+		unsigned size() const;
+
+		// queue a task as part of `group`
+		void run(TaskGroup& group, std::function<void()> task);
+
+		// run queued tasks until all tasks in `group` are complete.
+		// rethrows the first exception thrown by any of the group's tasks
+		void wait(TaskGroup& group);
+
+	private:
+
+		struct Task {
+			std::function<void()> function;
+			TaskGroup* group;
+		};
+
+		struct Queue {
+			std::mutex mutex;
+			std::deque<Task> tasks;
+		};
+
+		// takes a task from the current thread's own queue, or steals one from another
+		bool takeTask(Task& task);
+
+		// runs the task and marks it complete in its group
+		void execute(Task& task);
+
+		void workerLoop(std::size_t index);
+
+		// one queue per worker, followed by one shared by all other threads
+		std::vector<std::unique_ptr<Queue>> queues;
+		std::vector<std::thread> workers;
+
+		// number of tasks waiting in any queue, used to put idle workers to sleep
+		std::atomic<std::size_t> queued;
+		std::mutex sleep_mutex;
+		std::condition_variable sleep_cv;
+		bool stopping;
+	};
+
+} // namespace ui
@@ -106,7 +106,12 @@ namespace ui {
 			return scrollspeed;
 		}
 
-	private:
+	protected:
+
+		// called after the inner content is scrolled or resized
+		virtual void onScrollChanged() {
+
+		}
 
 		void onResize() override {
 			clipping_container->setSize(size(), true);
@@ -134,6 +139,7 @@ namespace ui {
 			}
 			xscrollbar->updateFromPanel();
 			yscrollbar->updateFromPanel();
+			onScrollChanged();
 		}
 
 		bool onScroll(float x, float y) override {
@@ -209,6 +215,7 @@ namespace ui {
 
 			xscrollbar->updateFromPanel();
 			yscrollbar->updateFromPanel();
+			onScrollChanged();
 		}
 
 		void gotoHome(bool horizontal) {
@@ -223,6 +230,7 @@ namespace ui {
 			}
 			xscrollbar->updateFromPanel();
 			yscrollbar->updateFromPanel();
+			onScrollChanged();
 		}
 
 		void gotoEnd(bool horizontal) {
@@ -237,6 +245,7 @@ namespace ui {
 			}
 			xscrollbar->updateFromPanel();
 			yscrollbar->updateFromPanel();
+			onScrollChanged();
 		}
 
 		struct ScrollButton : ui::FreeElement {
@@ -310,6 +319,7 @@ namespace ui {
 				setTop(std::min(std::max(top(), spacing), panel.height() - height() - thickness - 2.0f * spacing));
 				float pos_ratio = (top() - spacing) / (panel.height() - height() - thickness - 3.0f * spacing);
 				panel.innercontent->setTop(round(-pos_ratio * (panel.innercontent->height() - panel.height())));
+				panel.onScrollChanged();
 			}
 
 			ScrollPanel& panel;
@@ -346,6 +356,7 @@ namespace ui {
 				setLeft(std::min(std::max(left(), spacing), panel.width() - width() - thickness - 2.0f * spacing));
 				float pos_ratio = (left() - spacing) / (panel.width() - width() - thickness - 3.0f * spacing);
 				panel.innercontent->setLeft(round(-pos_ratio * (panel.innercontent->width() - panel.width())));
+				panel.onScrollChanged();
 			}
 
 			ScrollPanel& panel;
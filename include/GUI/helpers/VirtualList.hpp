@@ -0,0 +1,280 @@
+#pragma once
+
+#include "GUI/helpers/ScrollPanel.hpp"
+
+#include <cmath>
+#include <map>
+
+namespace ui {
+
+	// a scrolling list of rows of varying height in which only the rows in view, and a few
+	// around them, exist as elements. Rows are created on demand by a factory function,
+	// which is given a previously used row element to reuse if one is available
+	struct VirtualList : ScrollPanel {
+
+		// returns the element for the row at `index`. If `recycled` is not null, it is the
+		// element of a row that went out of view and may be updated and returned
+		using RowFactory = std::function<Ref<Element>(std::size_t index, Ref<Element> recycled)>;
+
+		VirtualList(std::size_t count, RowFactory factory, float estimated_row_height = 20.0f, std::size_t overscan = 4)
+			: ScrollPanel(false, true),
+			m_factory(std::move(factory)),
+			m_estimatedheight(estimated_row_height),
+			m_overscan(overscan),
+			m_updating(false) {
+
+			setCount(count);
+		}
+
+		// set the number of rows. Heights of rows that remain are kept
+		void setCount(std::size_t count) {
+			m_heights.resize(count, m_estimatedheight);
+			m_tree.assign(m_heights);
+			for (auto it = m_rows.begin(); it != m_rows.end();) {
+				if (it->first >= count) {
+					recycle(it->second);
+					it = m_rows.erase(it);
+				} else {
+					++it;
+				}
+			}
+			updateRows();
+		}
+
+		// get the number of rows
+		std::size_t count() const {
+			return m_heights.size();
+		}
+
+		// get the height of a row, which is an estimate until the row has been laid out
+		float rowHeight(std::size_t index) const {
+			return m_heights[index];
+		}
+
+		// get the distance from the top of the list to the top of a row
+		float rowTop(std::size_t index) const {
+			return static_cast<float>(m_tree.prefix(index));
+		}
+
+		// ask the factory again for all rows in view, such as after the underlying data changed
+		void refresh() {
+			for (auto& row : m_rows) {
+				bind(*row.second, row.first);
+			}
+		}
+
+		// scroll so that the top of the row is at the top of the list
+		void scrollToRow(std::size_t index) {
+			if (index >= count()) {
+				return;
+			}
+			float top = std::min(rowTop(index), std::max(static_cast<float>(m_tree.total()) - height(), 0.0f));
+			innercontent->setTop(-top);
+			updatePositions();
+		}
+
+	private:
+
+		// sums of row heights, supporting changes and prefix sums in O(log n).
+		// The sums are doubles since a float can't hold a million rows' tops exactly
+		struct HeightTree {
+			void assign(const std::vector<float>& heights) {
+				sums.assign(heights.size() + 1, 0.0);
+				for (std::size_t i = 1; i <= heights.size(); ++i) {
+					sums[i] += heights[i - 1];
+					std::size_t parent = i + (i & (~i + 1));
+					if (parent < sums.size()) {
+						sums[parent] += sums[i];
+					}
+				}
+			}
+
+			void add(std::size_t index, double delta) {
+				for (std::size_t i = index + 1; i < sums.size(); i += i & (~i + 1)) {
+					sums[i] += delta;
+				}
+			}
+
+			// total height of the first `count` rows
+			double prefix(std::size_t count) const {
+				double sum = 0.0;
+				for (std::size_t i = count; i > 0; i -= i & (~i + 1)) {
+					sum += sums[i];
+				}
+				return sum;
+			}
+
+			double total() const {
+				return prefix(sums.size() - 1);
+			}
+
+			// index of the row containing `y`, or the number of rows if `y` is past the end
+			std::size_t find(double y) const {
+				std::size_t pos = 0;
+				std::size_t step = 1;
+				while (step * 2 < sums.size()) {
+					step *= 2;
+				}
+				for (; step > 0; step /= 2) {
+					if (pos + step < sums.size() && sums[pos + step] <= y) {
+						pos += step;
+						y -= sums[pos];
+					}
+				}
+				return pos;
+			}
+
+			// 1-based Fenwick tree
+			std::vector<double> sums;
+		};
+
+		// holds the factory's element for one row and reports its height once laid out
+		struct Row : ui::FreeElement {
+			Row(VirtualList& _list) : list(_list), index(0) {
+				setBorderColor(sf::Color(0));
+				setBackgroundColor(sf::Color(0));
+			}
+
+			void onResize() override {
+				if (isVisible()) {
+					list.rowResized(index, height());
+				}
+			}
+
+			VirtualList& list;
+			std::size_t index;
+		};
+
+		void onResize() override {
+			ScrollPanel::onResize();
+			for (auto& row : m_rows) {
+				row.second->setMinWidth(width());
+				row.second->setMaxWidth(width());
+			}
+			updateRows();
+		}
+
+		void onScrollChanged() override {
+			updateRows();
+		}
+
+		// called while the inner content is being laid out, so rows are only moved here.
+		// The new scroll range has the inner content laid out again after its rows, and
+		// its onResize then brings the rows in view up to date through onScrollChanged.
+		// A range that stays the same means all rows fit in view and are present already
+		void rowResized(std::size_t index, float height) {
+			if (index >= m_heights.size() || std::abs(height - m_heights[index]) < 0.01f) {
+				return;
+			}
+			float delta = height - m_heights[index];
+			float top = rowTop(index);
+			m_heights[index] = height;
+			m_tree.add(index, delta);
+			updateScrollRange();
+
+			// keep the rows in view still when a row above them changes
+			if (top < -innercontent->top()) {
+				innercontent->setTop(innercontent->top() - delta);
+			}
+			for (auto it = m_rows.upper_bound(index); it != m_rows.end(); ++it) {
+				it->second->setTop(rowTop(it->first));
+			}
+		}
+
+		// creates rows coming into view and recycles those going out of view
+		void updateRows() {
+			if (m_updating) {
+				return;
+			}
+			m_updating = true;
+
+			updateScrollRange();
+
+			std::size_t first = 0, last = 0;
+			if (count() > 0) {
+				double view_top = -innercontent->top();
+				first = std::min(m_tree.find(view_top), count() - 1);
+				last = std::min(m_tree.find(view_top + height()), count() - 1);
+				first = first > m_overscan ? first - m_overscan : 0;
+				last = std::min(last + m_overscan, count() - 1);
+			}
+
+			for (auto it = m_rows.begin(); it != m_rows.end();) {
+				if (count() == 0 || it->first < first || it->first > last) {
+					recycle(it->second);
+					it = m_rows.erase(it);
+				} else {
+					++it;
+				}
+			}
+
+			if (count() > 0) {
+				for (std::size_t i = first; i <= last; ++i) {
+					if (m_rows.count(i) > 0) {
+						continue;
+					}
+					Ref<Row> row;
+					if (m_spare.empty()) {
+						row = innercontent->add<Row>(*this);
+					} else {
+						row = m_spare.back();
+						m_spare.pop_back();
+						row->setVisible(true);
+					}
+					m_rows[i] = row;
+					row->setMinWidth(width());
+					row->setMaxWidth(width());
+					row->setPos({ 0.0f, rowTop(i) });
+					bind(*row, i);
+				}
+			}
+
+			m_updating = false;
+		}
+
+		// sizes the inner content to the rows' total height
+		void updateScrollRange() {
+			vec2 min_size = { width(), std::max(height(), static_cast<float>(m_tree.total())) };
+			if (innercontent->minWidth() != min_size.x || innercontent->minHeight() != min_size.y) {
+				innercontent->setMinSize(min_size);
+			}
+		}
+
+		void bind(Row& row, std::size_t index) {
+			row.index = index;
+			Ref<Element> content = row.children().empty() ? nullptr : row.children().front();
+			Ref<Element> nu = m_factory(index, content);
+			if (nu != content) {
+				if (content) {
+					row.remove(content);
+				}
+				if (nu) {
+					row.adopt(nu);
+				}
+			} else if (content) {
+				// an unchanged row won't be laid out again, so its height applies now
+				rowResized(index, row.height());
+			}
+		}
+
+		// hides a row until it is needed again
+		void recycle(const Ref<Row>& row) {
+			row->setVisible(false);
+			m_spare.push_back(row);
+		}
+
+		RowFactory m_factory;
+		float m_estimatedheight;
+		std::size_t m_overscan;
+		bool m_updating;
+
+		std::vector<float> m_heights;
+		HeightTree m_tree;
+
+		// rows currently in use, by index
+		std::map<std::size_t, Ref<Row>> m_rows;
+		// rows not currently in use, which are hidden
+		std::vector<Ref<Row>> m_spare;
+	};
+
+} // namespace ui
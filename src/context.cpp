@@ -1,9 +1,70 @@
 #include "GUI/Context.hpp"
 #include "GUI/GUI.hpp"
 #include <iostream>
+#include <algorithm>
+#include <cmath>
 
 namespace ui {
 
+	namespace {
+		// beyond these, drawing the union of all damage once is cheaper than drawing many pieces
+		const std::size_t max_damage_rects = 64;
+		const std::size_t max_damage_regions = 8;
+
+		sf::FloatRect unite(const sf::FloatRect& a, const sf::FloatRect& b) {
+			float left = std::min(a.left, b.left);
+			float top = std::min(a.top, b.top);
+			float right = std::max(a.left + a.width, b.left + b.width);
+			float bottom = std::max(a.top + a.height, b.top + b.height);
+			return { left, top, right - left, bottom - top };
+		}
+
+		// round damaged areas out to whole pixels on the screen and join those which overlap
+		std::vector<sf::FloatRect> mergeDamage(const std::vector<sf::FloatRect>& damage, sf::Vector2u screen) {
+			std::vector<sf::FloatRect> regions;
+			for (const auto& rect : damage) {
+				float left = std::max(0.0f, std::floor(rect.left));
+				float top = std::max(0.0f, std::floor(rect.top));
+				float right = std::min((float)screen.x, std::ceil(rect.left + rect.width));
+				float bottom = std::min((float)screen.y, std::ceil(rect.top + rect.height));
+				if (right > left && bottom > top) {
+					regions.push_back({ left, top, right - left, bottom - top });
+				}
+			}
+			if (regions.size() > max_damage_rects) {
+				sf::FloatRect all = regions.front();
+				for (const auto& rect : regions) {
+					all = unite(all, rect);
+				}
+				return { all };
+			}
+
+			// join until no two overlap, so that nothing is drawn twice
+			bool joined = true;
+			while (joined) {
+				joined = false;
+				for (std::size_t i = 0; i < regions.size() && !joined; ++i) {
+					for (std::size_t j = i + 1; j < regions.size(); ++j) {
+						if (regions[i].intersects(regions[j])) {
+							regions[i] = unite(regions[i], regions[j]);
+							regions.erase(regions.begin() + j);
+							joined = true;
+							break;
+						}
+					}
+				}
+			}
+			if (regions.size() > max_damage_regions) {
+				sf::FloatRect all = regions.front();
+				for (const auto& rect : regions) {
+					all = unite(all, rect);
+				}
+				return { all };
+			}
+			return regions;
+		}
+	}
+
 	// calls `function` on `element` and all its ancestors until one returns true, and that element is returned
 	template<typename ...ArgsT>
 	Ref<Element> propagate(Ref<Element> element, bool (Element::* function)(ArgsT...), ArgsT... args) {
@@ -20,13 +81,25 @@ namespace ui {
 		quit(false),
 		render_delay(1.0f / 30.0f),
 		doubleclicktime(0.25f),
-		current_element(root().m_sharedthis) {
+		current_element(root().m_sharedthis),
+		hover_valid(false),
+		hover_generation(0),
+		hover_excluded(nullptr),
+		hover_continuous(false),
+		highlight_shown(false),
+		skipped_frames(0),
+		frame_pending(false),
+		render_stopping(false) {
 
 		program_time = clock.getElapsedTime().asSeconds();
 		highlight_timestamp = clock.getElapsedTime() - sf::seconds(10.0f);
 		click_timestamp = clock.getElapsedTime() - sf::seconds(10.0f);
 	}
 
+	Context::~Context() {
+		stopRenderThread();
+	}
+
 	void Context::init(unsigned _width, unsigned _height, std::string title, float _render_delay) {
 		render_delay = _render_delay;
 		sf::ContextSettings settings;
@@ -87,6 +160,10 @@ namespace ui {
 					newpath.pop_back();
 				}
 
+				// the old and new elements may be drawn differently
+				current_element->repaint();
+				element->repaint();
+
 				// prevent redundent calls
 				current_element = element;
 
@@ -106,7 +183,7 @@ namespace ui {
 	}
 
 	vec2 Context::getMousePosition() {
-		return (vec2)sf::Mouse::getPosition(renderwindow);
+		return (vec2)sf::Mouse::getPosition(getRenderWindow());
 	}
 
 	void Context::handleMouseDown(sf::Mouse::Button button, vec2 pos) {
@@ -307,14 +384,33 @@ namespace ui {
 	void Context::handleDrag() {
 		if (dragging_element) {
 			vec2 prev = dragging_element->pos();
-			dragging_element->m_pos = (vec2)sf::Mouse::getPosition(getRenderWindow()) - drag_offset;
+			dragging_element->m_pos = toFloat2((vec2)sf::Mouse::getPosition(getRenderWindow()) - drag_offset);
+			dragging_element->invalidateBounds();
 			dragging_element->onDrag(prev);
 		}
 	}
 
 	void Context::handleHover(vec2 pos) {
+		if (hover_valid && pos == hover_pos && root().geometryGeneration() == hover_generation && dragging_element.get() == hover_excluded) {
+			// nothing moved, so only those asking for it hear about the mouse
+			if (hover_continuous) {
+				for (auto element = hover_element; element; element = element->parent().lock()) {
+					if (element->continuousHover() && (dragging_element ? element->onHoverWith(dragging_element) : element->onHover())) {
+						break;
+					}
+				}
+			}
+			return;
+		}
+
 		auto element = root().findElementAt(pos, dragging_element);
 
+		// the callbacks below may change the layout, which is then looked at again
+		hover_valid = true;
+		hover_pos = pos;
+		hover_generation = root().geometryGeneration();
+		hover_excluded = dragging_element.get();
+
 		if (element != hover_element) {
 			// if the mouse is moved onto a new element
 
@@ -323,6 +419,14 @@ namespace ui {
 			auto newelem = element;
 			hover_element = element;
 
+			// the old and new elements may be drawn differently
+			if (oldelem) {
+				oldelem->repaint();
+			}
+			if (newelem) {
+				newelem->repaint();
+			}
+
 			while (oldelem) {
 				oldpath.push_back(oldelem);
 				oldelem = oldelem->parent().lock();
@@ -354,6 +458,15 @@ namespace ui {
 				propagate(hover_element, &Element::onHover);
 			}
 		}
+
+		hover_continuous = false;
+		for (auto element = hover_element; element && !hover_continuous; element = element->parent().lock()) {
+			hover_continuous = element->continuousHover();
+		}
+	}
+
+	void Context::invalidateHover() {
+		hover_valid = false;
 	}
 
 	void Context::handleQuit(bool force) {
@@ -369,42 +482,179 @@ namespace ui {
 	}
 
 	sf::RenderWindow& Context::getRenderWindow() {
-		return renderwindow;
+		if (!renderwindow) {
+			renderwindow = std::make_unique<sf::RenderWindow>();
+		}
+		return *renderwindow;
 	}
 
 	float Context::getRenderDelay() {
 		return render_delay;
 	}
 
-	void Context::setViewOffset(vec2 offset) {
-		view_offset = offset;
+	void Context::resetView() {
+		vec2 size = getScreenSize();
+		getRenderWindow().setView(sf::View(sf::FloatRect(0, 0, size.x, size.y)));
 	}
 
-	vec2 Context::getViewOffset() {
-		return view_offset;
+	void Context::addDamage(const sf::FloatRect& rect) {
+		damage.push_back(rect);
 	}
 
-	void Context::resetView() {
+	bool Context::renderFrame() {
 		vec2 size = getScreenSize();
-		clip_rect = sf::FloatRect(0, 0, size.x, size.y);
-		view_offset = vec2(0, 0);
-		updateView();
+		sf::Vector2u pixels((unsigned)std::ceil(size.x), (unsigned)std::ceil(size.y));
+		if (pixels.x == 0 || pixels.y == 0) {
+			return false;
+		}
+		// the old frame is no use at a new size
+		bool full = pixels != frame_size;
+		frame_size = pixels;
+
+		// the cursor blinks while typing
+		if (text_entry && text_entry->typing()) {
+			text_entry->repaint();
+		}
+
+		if (root().hasChanges()) {
+			for (const auto& child : root().m_children) {
+				if (child && child->hasChanges()) {
+					child->collectDamage(damage, vec2(), full);
+				}
+			}
+			root().clearChanges();
+		}
+
+		bool highlight = current_element && timeSinceHighlight() <= 2.0f;
+		if (!full && damage.empty() && !highlight && !highlight_shown) {
+			++skipped_frames;
+			return false;
+		}
+
+		frame.size = pixels;
+		if (full) {
+			frame.regions.assign(1, sf::FloatRect(0.0f, 0.0f, (float)pixels.x, (float)pixels.y));
+		} else {
+			frame.regions = mergeDamage(damage, pixels);
+		}
+		damage.clear();
+		if (frame.lists.size() < frame.regions.size()) {
+			frame.lists.resize(frame.regions.size());
+		}
+
+		// each region is drawn over with the background and then with everything in it
+		for (std::size_t i = 0; i < frame.regions.size(); ++i) {
+			const sf::FloatRect& region = frame.regions[i];
+			DrawList& list = frame.lists[i];
+			list.clear(region);
+			sf::RectangleShape background({ region.width, region.height });
+			background.setPosition({ region.left, region.top });
+			background.setFillColor(sf::Color::Black);
+			list.addShape(background, sf::RenderStates::Default);
+			root().recordChildren(list, sf::RenderStates::Default);
+		}
+
+		// the highlight is drawn over the frame only, so it is gone from the next
+		frame.highlight = highlight;
+		if (highlight) {
+			float value = exp(-timeSinceHighlight() * 3.453877f);
+			sf::Color color { 0xFFFF00FF };
+			color.a = (uint8_t)(std::min(value, 1.0f) * 255.0f);
+
+			frame.highlight_rect.setSize(current_element->size());
+			frame.highlight_rect.setPosition(current_element->absPos());
+			frame.highlight_rect.setFillColor(sf::Color(0));
+			frame.highlight_rect.setOutlineColor(color);
+			frame.highlight_rect.setOutlineThickness(2);
+		}
+		highlight_shown = highlight;
+
+		if (render_thread.joinable()) {
+			// the frame refers to textures and callbacks of elements, so nothing may
+			// change until it is drawn, but displaying it overlaps with the next frame
+			std::unique_lock<std::mutex> lock(render_mutex);
+			frame_pending = true;
+			render_condition.notify_all();
+			render_condition.wait(lock, [this] { return !frame_pending; });
+		} else {
+			drawFrame();
+			getRenderWindow().display();
+		}
+		return true;
 	}
 
-	const sf::FloatRect& Context::getClipRect() {
-		return clip_rect;
+	void Context::drawFrame() {
+		if (!canvas) {
+			canvas = std::make_unique<sf::RenderTexture>();
+		}
+		if (canvas->getSize() != frame.size) {
+			// shapes are drawn to the canvas instead of the window, so they are
+			// only smooth if it is antialiased as much as the window is
+			sf::ContextSettings settings;
+			settings.antialiasingLevel = getRenderWindow().getSettings().antialiasingLevel;
+			if (!canvas->create(frame.size.x, frame.size.y, settings)) {
+				return;
+			}
+		}
+		for (std::size_t i = 0; i < frame.regions.size(); ++i) {
+			frame.lists[i].draw(*canvas);
+		}
+		canvas->display();
+
+		getRenderWindow().setView(sf::View(sf::FloatRect(0.0f, 0.0f, (float)frame.size.x, (float)frame.size.y)));
+		getRenderWindow().draw(sf::Sprite(canvas->getTexture()));
+		if (frame.highlight) {
+			getRenderWindow().draw(frame.highlight_rect);
+		}
+	}
+
+	void Context::startRenderThread() {
+		if (render_thread.joinable()) {
+			return;
+		}
+		render_stopping = false;
+		// a context can only be active on one thread at a time
+		getRenderWindow().setActive(false);
+		render_thread = std::thread([this] {
+			getRenderWindow().setActive(true);
+			std::unique_lock<std::mutex> lock(render_mutex);
+			while (true) {
+				render_condition.wait(lock, [this] { return frame_pending || render_stopping; });
+				if (!frame_pending) {
+					break;
+				}
+				drawFrame();
+				frame_pending = false;
+				render_condition.notify_all();
+
+				// the next frame is recorded while this waits for the display
+				lock.unlock();
+				getRenderWindow().display();
+				lock.lock();
+			}
+			getRenderWindow().setActive(false);
+		});
+	}
+
+	void Context::stopRenderThread() {
+		if (!render_thread.joinable()) {
+			return;
+		}
+		{
+			std::lock_guard<std::mutex> lock(render_mutex);
+			render_stopping = true;
+			render_condition.notify_all();
+		}
+		render_thread.join();
+		getRenderWindow().setActive(true);
 	}
 
-	void Context::setClipRect(const sf::FloatRect& rect) {
-		clip_rect = rect;
+	unsigned long long Context::getSkippedFrames() const {
+		return skipped_frames;
 	}
 
-	void Context::intersectClipRect(const sf::FloatRect& rect) {
-		float left = std::max(clip_rect.left, rect.left);
-		float top = std::max(clip_rect.top, rect.top);
-		float right = std::min(clip_rect.left + clip_rect.width, rect.left + rect.width);
-		float bottom = std::min(clip_rect.top + clip_rect.height, rect.top + rect.height);
-		clip_rect = sf::FloatRect(left, top, right - left, bottom - top);
+	bool Context::isAnimating() const {
+		return !transitions.empty() || dragging_element || hover_continuous;
 	}
 
 	void Context::resize(int w, int h) {
@@ -442,6 +692,12 @@ namespace ui {
 	}
 
 	void Context::setTextEntry(Ref<TextEntry> textentry) {
+		if (text_entry) {
+			text_entry->repaint();
+		}
+		if (textentry) {
+			textentry->repaint();
+		}
 		text_entry = textentry;
 	}
 
@@ -453,23 +709,6 @@ namespace ui {
 		return program_time - highlight_timestamp.asSeconds();
 	}
 
-	void Context::updateView() {
-		vec2 size = getScreenSize();
-		sf::View view;
-		sf::FloatRect rect = getClipRect();
-		vec2 offset = getViewOffset() + vec2(rect.left, rect.top);
-		view.setSize(rect.width, rect.height);
-		view.setCenter(offset.x + rect.width * 0.5f, offset.y + rect.height * 0.5f);
-		sf::FloatRect vp = sf::FloatRect(
-			rect.left / size.x,
-			rect.top / size.y,
-			rect.width / size.x,
-			rect.height / size.y
-		);
-		view.setViewport(vp);
-		renderwindow.setView(view);
-	}
-
 	Context& getContext() {
 		static Context context;
 		return context;
@@ -0,0 +1,277 @@
+#include "GUI/DrawList.hpp"
+
+#include <algorithm>
+#include <cmath>
+
+namespace ui {
+
+	namespace {
+		// how many batches back geometry may go to join one with the same texture
+		const std::size_t max_lookback = 8;
+
+		sf::FloatRect boundsOf(const sf::Vertex* vertices, std::size_t count) {
+			if (count == 0) {
+				return {};
+			}
+			sf::Vector2f min = vertices[0].position;
+			sf::Vector2f max = vertices[0].position;
+			for (std::size_t i = 1; i < count; ++i) {
+				min.x = std::min(min.x, vertices[i].position.x);
+				min.y = std::min(min.y, vertices[i].position.y);
+				max.x = std::max(max.x, vertices[i].position.x);
+				max.y = std::max(max.y, vertices[i].position.y);
+			}
+			return { min, max - min };
+		}
+
+		sf::FloatRect join(const sf::FloatRect& a, const sf::FloatRect& b) {
+			if (a.width <= 0.0f || a.height <= 0.0f) {
+				return b;
+			}
+			float left = std::min(a.left, b.left);
+			float top = std::min(a.top, b.top);
+			float right = std::max(a.left + a.width, b.left + b.width);
+			float bottom = std::max(a.top + a.height, b.top + b.height);
+			return { left, top, right - left, bottom - top };
+		}
+
+		// a view showing `rect` of the screen in the same place on the target
+		sf::View clipView(const sf::FloatRect& rect, sf::Vector2u target_size) {
+			sf::View view(rect);
+			view.setViewport(sf::FloatRect(
+				rect.left / (float)target_size.x,
+				rect.top / (float)target_size.y,
+				rect.width / (float)target_size.x,
+				rect.height / (float)target_size.y
+			));
+			return view;
+		}
+
+		// the outward normal of the edge from `a` to `b`
+		sf::Vector2f edgeNormal(sf::Vector2f a, sf::Vector2f b, sf::Vector2f inside) {
+			sf::Vector2f normal { a.y - b.y, b.x - a.x };
+			float length = std::sqrt(normal.x * normal.x + normal.y * normal.y);
+			if (length > 0.0f) {
+				normal /= length;
+			}
+			if (normal.x * (inside.x - a.x) + normal.y * (inside.y - a.y) > 0.0f) {
+				normal = -normal;
+			}
+			return normal;
+		}
+	}
+
+	DrawList::DrawList() : m_batchcount(0) {
+		m_clipstack.push_back({});
+	}
+
+	void DrawList::clear(const sf::FloatRect& screen) {
+		m_commands.clear();
+		for (std::size_t i = 0; i < m_batchcount; ++i) {
+			m_batches[i].vertices.clear();
+		}
+		m_batchcount = 0;
+		m_clips.clear();
+		m_callbacks.clear();
+		m_clipstack.clear();
+		m_clipstack.push_back(screen);
+	}
+
+	void DrawList::addTriangles(const sf::Vertex* vertices, std::size_t count, const sf::RenderStates& states) {
+		if (count == 0) {
+			return;
+		}
+		Batch& batch = batchFor(states.texture, states.transform.transformRect(boundsOf(vertices, count)));
+		for (std::size_t i = 0; i < count; ++i) {
+			sf::Vertex vertex = vertices[i];
+			vertex.position = states.transform.transformPoint(vertex.position);
+			batch.vertices.push_back(vertex);
+		}
+	}
+
+	template<typename ShapeType>
+	void DrawList::addConvex(const ShapeType& shape, sf::Color fill, sf::Color outline, float thickness, const sf::Transform& transform, const sf::FloatRect& local) {
+		std::size_t count = shape.getPointCount();
+		bool has_outline = thickness != 0.0f && outline.a > 0;
+		if (count < 3 || (fill.a == 0 && !has_outline)) {
+			return;
+		}
+
+		sf::Vector2f inside { local.left + local.width * 0.5f, local.top + local.height * 0.5f };
+		sf::FloatRect bounds = local;
+		if (has_outline) {
+			// the outline reaches past the points
+			float t = std::abs(thickness);
+			bounds = { local.left - t, local.top - t, local.width + 2.0f * t, local.height + 2.0f * t };
+		}
+		Batch& batch = batchFor(nullptr, transform.transformRect(bounds));
+
+		if (fill.a > 0) {
+			// convex, so a fan around the first point
+			sf::Vector2f first = transform.transformPoint(shape.getPoint(0));
+			sf::Vector2f prev = transform.transformPoint(shape.getPoint(1));
+			for (std::size_t i = 2; i < count; ++i) {
+				sf::Vector2f next = transform.transformPoint(shape.getPoint(i));
+				batch.vertices.push_back(sf::Vertex(first, fill));
+				batch.vertices.push_back(sf::Vertex(prev, fill));
+				batch.vertices.push_back(sf::Vertex(next, fill));
+				prev = next;
+			}
+		}
+
+		if (has_outline) {
+			// each point is pushed out along the average of its edges' normals, as sf::Shape does
+			auto outer = [&](std::size_t i) {
+				sf::Vector2f p0 = shape.getPoint((i + count - 1) % count);
+				sf::Vector2f p1 = shape.getPoint(i);
+				sf::Vector2f p2 = shape.getPoint((i + 1) % count);
+				sf::Vector2f n1 = edgeNormal(p0, p1, inside);
+				sf::Vector2f n2 = edgeNormal(p1, p2, inside);
+				float factor = 1.0f + (n1.x * n2.x + n1.y * n2.y);
+				return p1 + (n1 + n2) * (thickness / factor);
+			};
+			sf::Vector2f first_inner = transform.transformPoint(shape.getPoint(0));
+			sf::Vector2f first_outer = transform.transformPoint(outer(0));
+			sf::Vector2f inner0 = first_inner;
+			sf::Vector2f outer0 = first_outer;
+			for (std::size_t i = 1; i <= count; ++i) {
+				sf::Vector2f inner1 = i < count ? transform.transformPoint(shape.getPoint(i)) : first_inner;
+				sf::Vector2f outer1 = i < count ? transform.transformPoint(outer(i)) : first_outer;
+				batch.vertices.push_back(sf::Vertex(inner0, outline));
+				batch.vertices.push_back(sf::Vertex(outer0, outline));
+				batch.vertices.push_back(sf::Vertex(inner1, outline));
+				batch.vertices.push_back(sf::Vertex(inner1, outline));
+				batch.vertices.push_back(sf::Vertex(outer0, outline));
+				batch.vertices.push_back(sf::Vertex(outer1, outline));
+				inner0 = inner1;
+				outer0 = outer1;
+			}
+		}
+	}
+
+	void DrawList::addShape(const sf::Shape& shape, const sf::RenderStates& states) {
+		addConvex(shape, shape.getFillColor(), shape.getOutlineColor(), shape.getOutlineThickness(), states.transform * shape.getTransform(), shape.getLocalBounds());
+	}
+
+	void DrawList::addShape(const RoundedRectangle& shape, const sf::RenderStates& states) {
+		addConvex(shape, shape.getFillColor(), shape.getOutlineColor(), shape.getOutlineThickness(), states.transform, shape.getLocalBounds());
+	}
+
+	void DrawList::addSprite(const sf::Sprite& sprite, const sf::RenderStates& states) {
+		const sf::Texture* texture = sprite.getTexture();
+		if (!texture) {
+			return;
+		}
+		sf::Transform transform = states.transform * sprite.getTransform();
+		sf::FloatRect local = sprite.getLocalBounds();
+		sf::IntRect rect = sprite.getTextureRect();
+		sf::Color color = sprite.getColor();
+
+		sf::Vector2f topleft = transform.transformPoint(local.left, local.top);
+		sf::Vector2f topright = transform.transformPoint(local.left + local.width, local.top);
+		sf::Vector2f bottomleft = transform.transformPoint(local.left, local.top + local.height);
+		sf::Vector2f bottomright = transform.transformPoint(local.left + local.width, local.top + local.height);
+		sf::Vector2f uv0 { (float)rect.left, (float)rect.top };
+		sf::Vector2f uv1 { (float)(rect.left + rect.width), (float)(rect.top + rect.height) };
+
+		Batch& batch = batchFor(texture, transform.transformRect(local));
+		batch.vertices.push_back(sf::Vertex(topleft, color, uv0));
+		batch.vertices.push_back(sf::Vertex(topright, color, { uv1.x, uv0.y }));
+		batch.vertices.push_back(sf::Vertex(bottomleft, color, { uv0.x, uv1.y }));
+		batch.vertices.push_back(sf::Vertex(bottomleft, color, { uv0.x, uv1.y }));
+		batch.vertices.push_back(sf::Vertex(topright, color, { uv1.x, uv0.y }));
+		batch.vertices.push_back(sf::Vertex(bottomright, color, uv1));
+	}
+
+	void DrawList::addCallback(std::function<void(sf::RenderTarget&)> callback) {
+		m_commands.push_back({ Command::Type::Callback, m_callbacks.size() });
+		m_callbacks.push_back(std::move(callback));
+	}
+
+	bool DrawList::pushClip(const sf::FloatRect& rect) {
+		const sf::FloatRect& clip = m_clipstack.back();
+		float left = std::max(clip.left, rect.left);
+		float top = std::max(clip.top, rect.top);
+		float right = std::min(clip.left + clip.width, rect.left + rect.width);
+		float bottom = std::min(clip.top + clip.height, rect.top + rect.height);
+		if (right <= left || bottom <= top) {
+			return false;
+		}
+		m_clipstack.push_back({ left, top, right - left, bottom - top });
+		m_commands.push_back({ Command::Type::Clip, m_clips.size() });
+		m_clips.push_back(m_clipstack.back());
+		return true;
+	}
+
+	void DrawList::popClip() {
+		// the screen is never popped
+		if (m_clipstack.size() > 1) {
+			m_clipstack.pop_back();
+			m_commands.push_back({ Command::Type::Clip, m_clips.size() });
+			m_clips.push_back(m_clipstack.back());
+		}
+	}
+
+	const sf::FloatRect& DrawList::clipRect() const {
+		return m_clipstack.back();
+	}
+
+	std::size_t DrawList::batchCount() const {
+		return m_batchcount;
+	}
+
+	void DrawList::draw(sf::RenderTarget& target) const {
+		sf::Vector2u size = target.getSize();
+		target.setView(clipView(m_clipstack.front(), size));
+		bool clipped = false;
+		for (const auto& command : m_commands) {
+			switch (command.type) {
+				case Command::Type::Batch: {
+					const Batch& batch = m_batches[command.index];
+					target.draw(batch.vertices.data(), batch.vertices.size(), sf::Triangles, sf::RenderStates(batch.texture));
+					break;
+				}
+				case Command::Type::Clip:
+					target.setView(clipView(m_clips[command.index], size));
+					clipped = true;
+					break;
+				case Command::Type::Callback:
+					m_callbacks[command.index](target);
+					break;
+			}
+		}
+		if (clipped) {
+			target.setView(clipView(m_clipstack.front(), size));
+		}
+	}
+
+	DrawList::Batch& DrawList::batchFor(const sf::Texture* texture, const sf::FloatRect& bounds) {
+		// walk back through recent batches, stopping at clipping and callbacks, and at
+		// anything overlapping which would then be drawn over instead of under
+		std::size_t lookback = 0;
+		for (auto it = m_commands.rbegin(); it != m_commands.rend() && lookback < max_lookback; ++it, ++lookback) {
+			if (it->type != Command::Type::Batch) {
+				break;
+			}
+			Batch& batch = m_batches[it->index];
+			if (batch.texture == texture) {
+				batch.bounds = join(batch.bounds, bounds);
+				return batch;
+			}
+			if (batch.bounds.intersects(bounds)) {
+				break;
+			}
+		}
+
+		if (m_batchcount == m_batches.size()) {
+			m_batches.emplace_back();
+		}
+		Batch& batch = m_batches[m_batchcount];
+		batch.texture = texture;
+		batch.bounds = bounds;
+		m_commands.push_back({ Command::Type::Batch, m_batchcount });
+		++m_batchcount;
+		return batch;
+	}
+
+} // namespace ui
@@ -4,36 +4,23 @@
 #include "GUI/RoundedRectangle.hpp"
 
 #include <algorithm>
+#include <cmath>
 #include <set>
 #include <sstream>
 
 namespace ui {
-	namespace {
-		const float epsilon = 0.0001f;
-		const float far_away = 1000000.0f;
-	}
 
 	Element::Element(LayoutStyle _display_style) :
+		LayoutNode(_display_style),
 		m_sharedthis(this),
-		m_layoutstyle(_display_style),
-		m_contentalign(ContentAlign::Left),
-		m_pos({ 0.0f, 0.0f }),
-		m_size({ 100.0f, 100.0f }),
-		m_minsize({ 0.0f, 0.0f }),
-		m_maxsize({ far_away, far_away }),
-		m_oldtotalsize({ 0.0f, 0.0f }),
 		m_disabled(false),
-		m_visible(true),
 		m_clipping(false),
 		m_keyboard_navigable(true),
-		m_isdirty(true),
-		m_layoutindex(0.0f),
-		m_padding(0.0f),
-		m_margin(0.0f),
-		m_pstyle_x(PositionStyle::None),
-		m_pstyle_y(PositionStyle::None),
-		m_spacing_x(0.0f),
-		m_spacing_y(0.0f) {
+		m_continuoushover(false),
+		m_emptychildslots(0),
+		m_childslot(0),
+		m_drawn(false),
+		m_repaint(false) {
 
 		m_displayrect.setSize(size());
 		m_displayrect.setFillColor(sf::Color(0));
@@ -42,12 +29,18 @@ namespace ui {
 	}
 
 	Element& Element::disable() {
-		m_disabled = true;
+		if (!m_disabled) {
+			m_disabled = true;
+			invalidateGeometry();
+		}
 		return *this;
 	}
 
 	Element& Element::enable() {
-		m_disabled = false;
+		if (m_disabled) {
+			m_disabled = false;
+			invalidateGeometry();
+		}
 		return *this;
 	}
 
@@ -70,19 +63,16 @@ namespace ui {
 	}
 
 	Element& Element::setVisible(bool is_visible) {
-		if (isVisible() != is_visible && layoutStyle() != LayoutStyle::Free) {
-			makeDirty();
-		}
-		m_visible = is_visible;
+		LayoutNode::setVisible(is_visible);
 		return *this;
 	}
 
-	bool Element::isVisible() const {
-		return m_visible;
-	}
-
 	Element& Element::setClipping(bool _clipping) {
-		m_clipping = _clipping;
+		if (m_clipping != _clipping) {
+			m_clipping = _clipping;
+			invalidateGeometry();
+			repaint();
+		}
 		return *this;
 	}
 
@@ -90,205 +80,103 @@ namespace ui {
 		return m_clipping;
 	}
 
-	vec2 Element::pos() const {
-		return m_pos;
+	Element& Element::setCached(bool _cached) {
+		if (_cached != cached()) {
+			if (_cached) {
+				m_cache = std::make_unique<Cache>();
+			} else {
+				m_cache = nullptr;
+			}
+			repaint();
+		}
+		return *this;
 	}
 
-	float Element::left() const {
-		return m_pos.x;
+	bool Element::cached() const {
+		return (bool)m_cache;
 	}
 
-	float Element::top() const {
-		return m_pos.y;
+	vec2 Element::pos() const {
+		return toVec2(LayoutNode::pos());
 	}
 
 	Element& Element::setPos(vec2 _pos) {
-		if (abs(left() - _pos.x) + abs(top() - _pos.y) > epsilon) {
-			m_pos = _pos;
-		}
-		if (m_layoutstyle == LayoutStyle::Free) {
-			updatePosition();
-		}
+		LayoutNode::setPos(toFloat2(_pos));
 		return *this;
 	}
 
-	Element & Element::setLeft(float x) {
-		return setPos({ x, top() });
+	Element& Element::setLeft(float x) {
+		LayoutNode::setLeft(x);
+		return *this;
 	}
 
-	Element & Element::setTop(float y) {
-		return setPos({ left(), y });
+	Element& Element::setTop(float y) {
+		LayoutNode::setTop(y);
+		return *this;
 	}
 
 	vec2 Element::size() const {
-		return m_size;
+		return toVec2(LayoutNode::size());
 	}
 
 	Element& Element::setSize(vec2 _size, bool force) {
-		_size = vec2(std::max(_size.x, 0.0f), std::max(_size.y, 0.0f));
-		if (abs(width() - _size.x) + abs(height() - _size.y) > epsilon) {
-			m_size = _size;
-			makeDirty();
-		}
-		if (force) {
-			if (minWidth() > width() || minHeight() > height() || maxWidth() < width() || maxHeight() < height()) {
-				makeDirty();
-			}
-			m_minsize = _size;
-			m_maxsize = _size;
-		}
+		LayoutNode::setSize(toFloat2(_size), force);
 		return *this;
 	}
 
 	Element& Element::setMinSize(vec2 _min_size) {
-		_min_size = vec2(std::max(_min_size.x, 0.0f), std::max(_min_size.y, 0.0f));
-		m_minsize = _min_size;
-		makeDirty();
+		LayoutNode::setMinSize(toFloat2(_min_size));
 		return *this;
 	}
 
 	vec2 Element::maxSize() const {
-		return m_maxsize;
+		return toVec2(LayoutNode::maxSize());
 	}
 
 	vec2 Element::minSize() const {
-		return m_minsize;
+		return toVec2(LayoutNode::minSize());
 	}
 
 	Element& Element::setMinWidth(float width) {
-		return setMinSize({ width, minHeight() });
+		LayoutNode::setMinWidth(width);
+		return *this;
 	}
 
 	Element& Element::setMinHeight(float height) {
-		return setMinSize({ minWidth(), height });
+		LayoutNode::setMinHeight(height);
+		return *this;
 	}
 
 	Element& Element::setMaxSize(vec2 _max_size) {
-		_max_size = vec2(std::max(_max_size.x, 0.0f), std::max(_max_size.y, 0.0f));
-		m_maxsize = _max_size;
-		makeDirty();
+		LayoutNode::setMaxSize(toFloat2(_max_size));
 		return *this;
 	}
 
 	Element& Element::setMaxWidth(float width) {
-		return setMaxSize({ width, maxHeight() });
+		LayoutNode::setMaxWidth(width);
+		return *this;
 	}
 
 	Element& Element::setWidth(float _width, bool force) {
-		_width = std::max(0.0f, _width);
-		if (abs(width() - _width) > epsilon) {
-			m_size.x = _width;
-			makeDirty();
-		}
-		if (force) {
-			if (width() < minWidth() || width() > maxWidth()) {
-				makeDirty();
-			}
-			m_minsize.x = _width;
-			m_maxsize.x = _width;
-		}
+		LayoutNode::setWidth(_width, force);
 		return *this;
 	}
 
-	float Element::minWidth() const {
-		return m_minsize.x;
-	}
-
-	float Element::maxWidth() const {
-		return m_maxsize.x;
-	}
-
-	float Element::width() const {
-		return m_size.x;
-	}
-
 	Element& Element::setMaxHeight(float height) {
-		return setMaxSize({ maxWidth(), height });
+		LayoutNode::setMaxHeight(height);
+		return *this;
 	}
 
 	Element& Element::setHeight(float _height, bool force) {
-		_height = std::max(0.0f, _height);
-		if (abs(height() - _height) > epsilon) {
-			m_size.y = _height;
-			makeDirty();
-		}
-		if (force) {
-			if (height() < minHeight() || height() > maxHeight()) {
-				makeDirty();
-			}
-			m_minsize.y = _height;
-			m_maxsize.y = _height;
-		}
+		LayoutNode::setHeight(_height, force);
 		return *this;
 	}
 
-	float Element::maxHeight() const {
-		return m_maxsize.y;
-	}
-
-	float Element::minHeight() const {
-		return m_minsize.y;
-	}
-
-	float Element::height() const {
-		return m_size.y;
-	}
-
-	void Element::onResize() {
-
-	}
-
-	void Element::setLayoutStyle(LayoutStyle style) {
-		if (layoutStyle() != style) {
-			m_layoutstyle = style;
-			if (auto par = parent().lock()) {
-				par->makeDirty();
-			}
-		}
-	}
-
-	LayoutStyle Element::layoutStyle() const {
-		return m_layoutstyle;
-	}
-
 	Element& Element::setContentAlign(ContentAlign style) {
-		if (contentAlign() != style) {
-			m_contentalign = style;
-			makeDirty();
-		}
+		LayoutNode::setContentAlign(style);
 		return *this;
 	}
 
-	ContentAlign Element::contentAlign() const {
-		return m_contentalign;
-	}
-
-	void Element::setXPositionStyle(PositionStyle style, float spacing) {
-		m_pstyle_x = style;
-		m_spacing_x = spacing;
-	}
-
-	PositionStyle Element::xPositionStyle() const {
-		return m_pstyle_x;
-	}
-
-	float Element::xPositionSpacing() const {
-		return m_spacing_x;
-	}
-
-	void Element::setYPositionStyle(PositionStyle style, float spacing) {
-		m_pstyle_y = style;
-		m_spacing_y = spacing;
-	}
-
-	PositionStyle Element::yPositionStyle() const {
-		return m_pstyle_y;
-	}
-
-	float Element::yPositionSpacing() const {
-		return m_spacing_y;
-	}
-
 	Element::~Element() {
 
 	}
@@ -299,10 +187,16 @@ namespace ui {
 		}
 		onClose();
 		while (!m_children.empty()) {
-			if (m_children.back()->inFocus()) {
+			Ref<Element> child = m_children.back();
+			if (!child) {
+				m_children.pop_back();
+				--m_emptychildslots;
+				continue;
+			}
+			if (child->inFocus()) {
 				grabFocus();
 			}
-			m_children.back()->close();
+			child->close();
 		}
 		auto self = m_sharedthis;
 		m_sharedthis = nullptr;
@@ -323,6 +217,10 @@ namespace ui {
 		return ((testpos.x >= 0.0f) && (testpos.x < width()) && (testpos.y >= 0.0f) && (testpos.y < height()));
 	}
 
+	bool Element::hitExtendsBounds() const {
+		return false;
+	}
+
 	vec2 Element::localMousePos() const {
 		vec2 mousepos = (vec2)sf::Mouse::getPosition(getContext().getRenderWindow());
 		Ref<const Element> element = m_sharedthis;
@@ -424,6 +322,26 @@ namespace ui {
 		return false;
 	}
 
+	Element& Element::enableContinuousHover() {
+		if (!m_continuoushover) {
+			m_continuoushover = true;
+			getContext().invalidateHover();
+		}
+		return *this;
+	}
+
+	Element& Element::disableContinuousHover() {
+		if (m_continuoushover) {
+			m_continuoushover = false;
+			getContext().invalidateHover();
+		}
+		return *this;
+	}
+
+	bool Element::continuousHover() const {
+		return m_continuoushover;
+	}
+
 	void Element::drop(vec2 local_pos) {
 		vec2 drop_pos = absPos() + local_pos;
 		if (auto element = root().findElementAt(drop_pos, m_sharedthis)) {
@@ -474,9 +392,11 @@ namespace ui {
 	void Element::write(const std::wstring& text, sf::Font& font, sf::Color color, unsigned charsize, TextStyle style) {
 		std::wstring word;
 
+		// words and white space are attached without dirtying, which is done once at the end
 		auto writeWord = [&, this]() {
 			if (word.size() > 0) {
-				this->add<ui::Text>(word, font, color, charsize, style);
+				auto rawtext = new ui::Text(word, font, color, charsize, style);
+				this->attachChild(rawtext->thisAs<ui::Text>());
 				word.clear();
 			}
 		};
@@ -484,10 +404,10 @@ namespace ui {
 		for (const wchar_t& ch : text) {
 			if (ch == L'\n') {
 				writeWord();
-				writeLineBreak(charsize);
+				m_layoutsequence.push_back({ nullptr, WhiteSpace(WhiteSpace::LineBreak, charsize) });
 			} else if (ch == L'\t') {
 				writeWord();
-				writeTab();
+				m_layoutsequence.push_back({ nullptr, WhiteSpace(WhiteSpace::Tab, 15u) });
 			} else if (ch == L' ') {
 				writeWord();
 			} else {
@@ -495,11 +415,7 @@ namespace ui {
 			}
 		}
 		writeWord();
-	}
-
-	void Element::writeLineBreak(unsigned charsize) {
-		m_whitespaces.push_back(WhiteSpace(WhiteSpace::LineBreak, getNextLayoutIndex(), charsize));
-		makeDirty();
+		childrenChanged();
 	}
 
 	void Element::writePageBreak(float height) {
@@ -511,12 +427,6 @@ namespace ui {
 		br->setSize({ 0.0f, 0.0f });
 	}
 
-	void Element::writeTab(float width) {
-		unsigned charsize = static_cast<unsigned>(floor(width / 50.0f * 15.0f));
-		m_whitespaces.push_back(WhiteSpace(WhiteSpace::Tab, getNextLayoutIndex(), charsize));
-		makeDirty();
-	}
-
 	void Element::adopt(Ref<Element> child) {
 		if (auto p = child->parent().lock()) {
 			if (p.get() == this) {
@@ -524,74 +434,173 @@ namespace ui {
 			}
 			p->release(child);
 		}
+		attachChild(child);
+		childrenChanged();
+	}
+
+	void Element::replaceChildren(const std::vector<Ref<Element>>& newchildren) {
+		auto focused = childInFocus();
+
+		// detach everything, remembering the old children so that
+		// those which are not adopted again can be destroyed afterwards
+		std::vector<Ref<Element>> oldchildren = std::move(m_children);
+		m_children.clear();
+		m_emptychildslots = 0;
+		m_layoutsequence.clear();
+		for (const auto& child : oldchildren) {
+			if (child) {
+				child->eraseDrawn();
+				child->m_parent = {};
+				child->m_layoutparent = nullptr;
+			}
+		}
+
+		m_children.reserve(newchildren.size());
+		for (const auto& child : newchildren) {
+			if (auto p = child->parent().lock()) {
+				if (p.get() == this) {
+					// listed twice
+					continue;
+				}
+				p->release(child);
+			}
+			attachChild(child);
+		}
+
+		if (focused && !has(focused)) {
+			grabFocus();
+		}
+		for (const auto& child : oldchildren) {
+			if (child && !child->m_parent.lock()) {
+				child->close();
+			}
+		}
+		childrenChanged();
+	}
+
+	void Element::attachChild(const Ref<Element>& child) {
+		child->m_childslot = m_children.size();
 		m_children.push_back(child);
 		child->m_parent = m_sharedthis;
-		child->m_layoutindex = getNextLayoutIndex();
-		makeDirty();
-		if (layoutStyle() != LayoutStyle::Free)
-			if (auto p = parent().lock()) {
-				p->makeDirty();
+		child->m_layoutparent = this;
+		child->m_layoutslot = m_layoutsequence.insert(m_layoutsequence.end(), { child.get(), WhiteSpace(WhiteSpace::None) });
+		child->markChanged();
+	}
+
+	Ref<Element> Element::childInFocus() const {
+		auto elem = getContext().getCurrentElement();
+		while (elem) {
+			auto p = elem->parent().lock();
+			if (p.get() == this) {
+				return elem;
 			}
+			elem = p;
+		}
+		return nullptr;
 	}
 
 	void Element::remove(Ref<Element> element) {
-		if (element) {
-			for (auto it = m_children.begin(); it != m_children.end(); ++it) {
-				if (*it == element) {
-					if (element->ancestorInFocus()) {
-						grabFocus();
-					}
-					m_children.erase(it);
-					element->m_parent = {};
-					element->close();
-					organizeLayoutIndices();
-					makeDirty();
-					return;
-				}
+		if (element && has(element)) {
+			if (element->ancestorInFocus()) {
+				grabFocus();
 			}
+			detachChild(*element);
+			element->close();
+			makeDirty();
 		}
 	}
 
 	Ref<Element> Element::release(Ref<Element> element) {
-		if (element) {
-			for (auto it = m_children.begin(); it != m_children.end(); ++it) {
-				if (*it == element) {
-					if (element->ancestorInFocus()) {
-						grabFocus();
-					}
-					m_children.erase(it);
-					element->m_parent = {};
-					organizeLayoutIndices();
-					makeDirty();
-					return element;
-				}
+		if (element && has(element)) {
+			if (element->ancestorInFocus()) {
+				grabFocus();
 			}
+			detachChild(*element);
+			makeDirty();
+			return element;
 		}
 		return nullptr;
 	}
 
+	void Element::detachChild(Element& child) {
+		child.eraseDrawn();
+		invalidateGeometry();
+		m_layoutsequence.erase(child.m_layoutslot);
+		child.m_parent = {};
+		child.m_layoutparent = nullptr;
+
+		if (child.m_childslot + 1 == m_children.size()) {
+			// removing from the end, as when clearing, needs no empty slot
+			m_children.pop_back();
+			while (!m_children.empty() && !m_children.back()) {
+				m_children.pop_back();
+				--m_emptychildslots;
+			}
+		} else {
+			m_children[child.m_childslot] = nullptr;
+			++m_emptychildslots;
+			if (m_emptychildslots * 2 > m_children.size()) {
+				compactChildren();
+			}
+		}
+	}
+
+	void Element::compactChildren() const {
+		if (m_emptychildslots == 0) {
+			return;
+		}
+		std::size_t slot = 0;
+		for (auto& child : m_children) {
+			if (child) {
+				child->m_childslot = slot;
+				m_children[slot++] = std::move(child);
+			}
+		}
+		m_children.resize(slot);
+		m_emptychildslots = 0;
+	}
+
 	bool Element::has(const Ref<Element>& child) const {
-		return child->parent().lock().get() == this;
+		return child->m_parent.lock().get() == this;
 	}
 
 	void Element::bringToFront() {
 		if (auto p = parent().lock()) {
-			for (auto it = p->m_children.begin(); it != p->m_children.end(); ++it) {
-				if ((*it).get() == this) {
-					p->m_children.erase(it);
-					p->m_children.push_back(m_sharedthis);
-					return;
-				}
+			if (m_childslot + 1 == p->m_children.size()) {
+				return;
+			}
+			p->m_children[m_childslot] = nullptr;
+			++p->m_emptychildslots;
+			m_childslot = p->m_children.size();
+			p->m_children.push_back(m_sharedthis);
+			// now drawn over its siblings
+			repaint();
+			p->invalidateGeometry();
+			if (p->m_emptychildslots * 2 > p->m_children.size()) {
+				p->compactChildren();
 			}
 		}
 	}
 
 	void Element::clear() {
-		while (m_children.size() > 0) {
-			m_children.back()->close();
+		if (childInFocus()) {
+			grabFocus();
 		}
+
+		// detach all children at once so that closing them doesn't remove them one by one
+		std::vector<Ref<Element>> oldchildren = std::move(m_children);
 		m_children.clear();
-		makeDirty();
+		m_emptychildslots = 0;
+		m_layoutsequence.clear();
+		for (const auto& child : oldchildren) {
+			if (child) {
+				child->eraseDrawn();
+				child->m_parent = {};
+				child->m_layoutparent = nullptr;
+				child->close();
+			}
+		}
+		childrenChanged();
 	}
 
 	Ref<Element> Element::findElementAt(vec2 _pos, Ref<Element> exclude) {
@@ -608,10 +617,43 @@ namespace ui {
 		}
 
 		Ref<Element> element;
-		for (auto it = m_children.rbegin(); it != m_children.rend(); ++it) {
-			element = (*it)->findElementAt(_pos - (*it)->pos(), exclude);
-			if (element) {
-				return element;
+		if (m_children.size() >= min_indexed_children) {
+			// only the children whose area includes the point, frontmost first
+			const HitIndex& index = hitIndex();
+			const HitEntry* cell = nullptr;
+			const HitEntry* cellend = nullptr;
+			vec2 offset = (_pos - index.origin) / index.cellsize;
+			if (offset.x >= 0.0f && offset.y >= 0.0f && offset.x <= (float)index.columns && offset.y <= (float)index.rows) {
+				// the far edges belong to the last cells
+				std::size_t x = std::min((std::size_t)offset.x, index.columns - 1);
+				std::size_t y = std::min((std::size_t)offset.y, index.rows - 1);
+				std::size_t i = y * index.columns + x;
+				cell = index.entries.data() + index.cellstart[i];
+				cellend = index.entries.data() + index.cellstart[i + 1];
+			}
+			const HitEntry* large = index.large.data();
+			const HitEntry* largeend = large + index.large.size();
+			while (cell != cellend || large != largeend) {
+				Element* child;
+				if (large == largeend || (cell != cellend && cell->order < large->order)) {
+					child = (cell++)->element;
+				} else {
+					child = (large++)->element;
+				}
+				element = child->findElementAt(_pos - child->pos(), exclude);
+				if (element) {
+					return element;
+				}
+			}
+		} else {
+			for (auto it = m_children.rbegin(); it != m_children.rend(); ++it) {
+				if (!*it) {
+					continue;
+				}
+				element = (*it)->findElementAt(_pos - (*it)->pos(), exclude);
+				if (element) {
+					return element;
+				}
 			}
 		}
 
@@ -622,8 +664,189 @@ namespace ui {
 		return nullptr;
 	}
 
-	void Element::render(sf::RenderWindow& rw) {
-		rw.draw(m_displayrect);
+	const Element::HitIndex& Element::hitIndex() {
+		if (!m_hitindex) {
+			m_hitindex = std::make_unique<HitIndex>();
+		} else if (m_hitindex->generation == geometryGeneration()) {
+			return *m_hitindex;
+		}
+		HitIndex& index = *m_hitindex;
+		index.generation = geometryGeneration();
+		index.entries.clear();
+		index.large.clear();
+
+		// children which can't be found don't need to be indexed, and
+		// children which may be hit anywhere can't be
+		auto findable = [](const Ref<Element>& child) {
+			return child && child->isVisible() && child->isEnabled();
+		};
+		auto indexable = [&](const Ref<Element>& child) {
+			return findable(child) && !child->hitExtendsBounds();
+		};
+		auto areaOf = [](Element& child) {
+			Bounds bounds = child.subtreeBounds();
+			Float2 pos = child.LayoutNode::pos();
+			return Bounds { bounds.min + pos, bounds.max + pos };
+		};
+
+		// about one child per cell, over the area covered by all of them
+		std::size_t count = 0;
+		Bounds all;
+		for (const auto& child : m_children) {
+			if (indexable(child)) {
+				Bounds area = areaOf(*child);
+				if (count == 0) {
+					all = area;
+				} else {
+					all.min = Float2(std::min(all.min.x, area.min.x), std::min(all.min.y, area.min.y));
+					all.max = Float2(std::max(all.max.x, area.max.x), std::max(all.max.y, area.max.y));
+				}
+				++count;
+			}
+		}
+		Float2 extent = all.max - all.min;
+		float cellsize = std::sqrt(std::max(extent.x * extent.y, 1.0f) / (float)std::max(count, std::size_t(1)));
+		cellsize = std::max({ cellsize, 1.0f, extent.x / (float)max_hit_cells, extent.y / (float)max_hit_cells });
+		index.origin = toVec2(all.min);
+		index.cellsize = cellsize;
+		index.columns = std::min((std::size_t)(extent.x / cellsize) + 1, max_hit_cells);
+		index.rows = std::min((std::size_t)(extent.y / cellsize) + 1, max_hit_cells);
+		index.cellstart.assign(index.columns * index.rows + 1, 0);
+
+		// the cells a child covers, or false if it covers too many to list it in each
+		auto cellsOf = [&](Element& child, std::size_t& x0, std::size_t& y0, std::size_t& x1, std::size_t& y1) {
+			Bounds area = areaOf(child);
+			auto cell = [&](float v, std::size_t cells) {
+				return std::min((std::size_t)std::max(v / cellsize, 0.0f), cells - 1);
+			};
+			x0 = cell(area.min.x - all.min.x, index.columns);
+			y0 = cell(area.min.y - all.min.y, index.rows);
+			x1 = cell(area.max.x - all.min.x, index.columns);
+			y1 = cell(area.max.y - all.min.y, index.rows);
+			return (x1 - x0 + 1) * (y1 - y0 + 1) <= max_cells_per_child;
+		};
+
+		// count the children in each cell, frontmost first, then place them
+		std::size_t x0, y0, x1, y1;
+		for (auto it = m_children.rbegin(); it != m_children.rend(); ++it) {
+			if (indexable(*it) && cellsOf(**it, x0, y0, x1, y1)) {
+				for (std::size_t y = y0; y <= y1; ++y) {
+					for (std::size_t x = x0; x <= x1; ++x) {
+						++index.cellstart[y * index.columns + x + 1];
+					}
+				}
+			}
+		}
+		for (std::size_t i = 1; i < index.cellstart.size(); ++i) {
+			index.cellstart[i] += index.cellstart[i - 1];
+		}
+		index.entries.resize(index.cellstart.back());
+		std::vector<std::uint32_t> next(index.cellstart.begin(), index.cellstart.end() - 1);
+		std::uint32_t order = 0;
+		for (auto it = m_children.rbegin(); it != m_children.rend(); ++it) {
+			if (!findable(*it)) {
+				continue;
+			}
+			HitEntry entry { order++, it->get() };
+			if (indexable(*it) && cellsOf(**it, x0, y0, x1, y1)) {
+				for (std::size_t y = y0; y <= y1; ++y) {
+					for (std::size_t x = x0; x <= x1; ++x) {
+						index.entries[next[y * index.columns + x]++] = entry;
+					}
+				}
+			} else {
+				index.large.push_back(entry);
+			}
+		}
+		return index;
+	}
+
+	void Element::record(DrawList& list, sf::RenderStates states) {
+		// the layout engine doesn't know about the display rect, so it follows the size here
+		if (m_displayrect.getSize() != size()) {
+			m_displayrect.setSize(size());
+		}
+		list.addShape(m_displayrect, states);
+	}
+
+	void Element::render(sf::RenderTarget&, sf::RenderStates) {
+
+	}
+
+	void Element::recordRender(DrawList& list, sf::RenderStates states) {
+		list.addCallback([this, states](sf::RenderTarget& target) {
+			render(target, states);
+		});
+	}
+
+	Bounds Element::ownBounds() const {
+		float border = m_displayrect.getOutlineThickness();
+		return { Float2(-border, -border), toFloat2(size()) + Float2(border, border) };
+	}
+
+	bool Element::clipsDescendants() const {
+		return m_clipping;
+	}
+
+	void Element::repaint() {
+		m_repaint = true;
+		markChanged();
+	}
+
+	void Element::collectDamage(std::vector<sf::FloatRect>& damage, vec2 origin, bool covered) {
+		vec2 position = origin + pos();
+		bool redraw = m_repaint;
+		if (m_cache) {
+			// anything changing inside means drawing the cache again
+			bool inside = m_repaint || m_relaidout;
+			for (const auto& child : m_children) {
+				inside = inside || (child && child->hasChanges());
+			}
+			if (inside) {
+				m_cache->valid = false;
+				redraw = true;
+			}
+		}
+		if (!isVisible()) {
+			// whatever was drawn of it is gone
+			if (!covered) {
+				eraseDrawn();
+			}
+			m_drawn = false;
+			covered = true;
+		} else if (!covered) {
+			Bounds own = ownBounds();
+			sf::FloatRect rect(position + toVec2(own.min), toVec2(own.max - own.min));
+			if (redraw || !m_drawn || rect != m_drawnrect) {
+				// drawn again in full, where it was and where it is now
+				if (m_drawn) {
+					damage.push_back(m_drawnarea);
+				}
+				Bounds bounds = subtreeBounds();
+				damage.push_back(sf::FloatRect(position + toVec2(bounds.min), toVec2(bounds.max - bounds.min)));
+				covered = true;
+			} else if (m_relaidout) {
+				// what it draws itself may have moved, such as a paragraph's words
+				damage.push_back(rect);
+			}
+		}
+		m_repaint = false;
+		clearChanges();
+
+		// the descendants of a cached element were never drawn on the screen themselves
+		covered = covered || m_cache != nullptr;
+		for (const auto& child : m_children) {
+			if (child && child->hasChanges()) {
+				child->collectDamage(damage, position, covered);
+			}
+		}
+	}
+
+	void Element::eraseDrawn() {
+		if (m_drawn) {
+			getContext().addDamage(m_drawnarea);
+			m_drawn = false;
+		}
 	}
 
 	bool Element::navigateToPreviousElement() {
@@ -634,25 +857,23 @@ namespace ui {
 		if (!par) {
 			return false;
 		}
-		std::map<LayoutIndex, Ref<Element>> siblings;
-		for (const auto& sib : par->children()) {
-			if (sib->isEnabled() && sib->isVisible()) {
-				siblings[sib->m_layoutindex] = sib;
-			}
-		}
-		if (siblings.size() < 2) {
-			return par->navigateToPreviousElement();
-		}
 
-		auto self = siblings.find(this->m_layoutindex);
+		// walk backwards through the layout sequence, wrapping around
+		auto& sequence = par->m_layoutsequence;
+		auto it = m_layoutslot;
+		do {
+			if (it == sequence.begin()) {
+				it = sequence.end();
+			}
+			--it;
+			if (it->node && it->node != this && static_cast<Element*>(it->node)->isEnabled() && it->node->isVisible()) {
+				static_cast<Element*>(it->node)->grabFocus();
+				getContext().highlightCurrentElement();
+				return true;
+			}
+		} while (it != m_layoutslot);
 
-		if (self == siblings.begin()) {
-			self = siblings.end();
-		}
-		--self;
-		self->second->grabFocus();
-		getContext().highlightCurrentElement();
-		return true;
+		return par->navigateToPreviousElement();
 	}
 
 	bool Element::navigateToNextElement() {
@@ -663,51 +884,53 @@ namespace ui {
 		if (!par) {
 			return false;
 		}
-		std::map<LayoutIndex, Ref<Element>> siblings;
-		for (const auto& sib : par->children()) {
-			if (sib->isEnabled() && sib->isVisible()) {
-				siblings[sib->m_layoutindex] = sib;
-			}
-		}
-		if (siblings.size() < 2) {
-			return par->navigateToNextElement();
-		}
 
-		auto self = siblings.find(this->m_layoutindex);
+		// walk forwards through the layout sequence, wrapping around
+		auto& sequence = par->m_layoutsequence;
+		auto it = m_layoutslot;
+		do {
+			++it;
+			if (it == sequence.end()) {
+				it = sequence.begin();
+			}
+			if (it->node && it->node != this && static_cast<Element*>(it->node)->isEnabled() && it->node->isVisible()) {
+				static_cast<Element*>(it->node)->grabFocus();
+				getContext().highlightCurrentElement();
+				return true;
+			}
+		} while (it != m_layoutslot);
 
-		++self;
-		if (self == siblings.end()) {
-			self = siblings.begin();
-		}
-		self->second->grabFocus();
-		getContext().highlightCurrentElement();
-		return true;
+		return par->navigateToNextElement();
 	}
 
 	bool Element::navigateIn() {
 		if (!inFocus()) {
 			return false;
 		}
-		std::map<LayoutIndex, Ref<Element>> elems;
-		for (const auto& child : children()) {
-			if (child->isEnabled() && child->isVisible()) {
-				elems[child->m_layoutindex] = child;
+		Element* first = nullptr;
+		bool many = false;
+		for (const auto& item : m_layoutsequence) {
+			if (item.node && static_cast<Element*>(item.node)->isEnabled() && item.node->isVisible()) {
+				if (first) {
+					many = true;
+					break;
+				}
+				first = static_cast<Element*>(item.node);
 			}
 		}
-		if (elems.size() == 0) {
+		if (!first) {
 			if (!inFocus()) {
 				grabFocus();
 				getContext().highlightCurrentElement();
 			}
 			return true;
-		} else if (elems.size() == 1) {
-			return elems.begin()->second->navigateIn();
-		} else if (elems.size() > 1) {
-			elems.begin()->second->grabFocus();
+		} else if (!many) {
+			return first->navigateIn();
+		} else {
+			first->grabFocus();
 			getContext().highlightCurrentElement();
 			return true;
 		}
-		return false;
 	}
 
 	bool Element::navigateOut() {
@@ -719,8 +942,8 @@ namespace ui {
 			return false;
 		}
 		int count = 0;
-		for (const auto& sib : par->children()) {
-			if (sib->isEnabled() && sib->isVisible()) {
+		for (const auto& sib : par->m_children) {
+			if (sib && sib->isEnabled() && sib->isVisible()) {
 				++count;
 			}
 		}
@@ -733,70 +956,91 @@ namespace ui {
 		}
 	}
 
-	void Element::renderChildren(sf::RenderWindow& renderwindow) {
-		// save view state
-		const vec2 offset = getContext().getViewOffset();
-		const sf::FloatRect cliprect = getContext().getClipRect();
+	void Element::recordChildren(DrawList& list, sf::RenderStates states) {
+		const sf::Transform transform = states.transform;
 		for (auto it = m_children.begin(); it != m_children.end(); ++it) {
 			const Ref<Element>& child = *it;
-			if (child->isVisible() && child) {
-				if (child->clipping()) {
-					auto childrect = sf::FloatRect(-offset + child->pos(), child->size());
-					if (!getContext().getClipRect().intersects(childrect)) {
-						// restore previous view state
-						getContext().setViewOffset(offset);
-						getContext().setClipRect(cliprect);
-						continue;
-					}
-					getContext().setViewOffset(offset - child->pos());
-					sf::FloatRect rect = getContext().getClipRect();
-					getContext().intersectClipRect(sf::FloatRect(-offset, child->size()));
-					getContext().updateView();
-					child->render(renderwindow);
-					child->renderChildren(renderwindow);
-				} else {
-					getContext().setViewOffset(offset - child->pos());
-					getContext().updateView();
-					child->render(renderwindow);
-					child->renderChildren(renderwindow);
+			if (!child || !child->isVisible()) {
+				continue;
+			}
+			// children are only translated, so a transform is all that changes
+			// between them, and clipping is only recorded for children that clip
+			states.transform = transform;
+			states.transform.translate(child->pos());
+
+			// skip subtrees which are entirely out of view, clipping or not
+			Bounds bounds = child->subtreeBounds();
+			sf::FloatRect area = states.transform.transformRect(sf::FloatRect(toVec2(bounds.min), toVec2(bounds.max - bounds.min)));
+			if (!area.intersects(list.clipRect())) {
+				continue;
+			}
+
+			// remember where it was drawn, to draw there again once it changes
+			Bounds own = child->ownBounds();
+			child->m_drawn = true;
+			child->m_drawnrect = states.transform.transformRect(sf::FloatRect(toVec2(own.min), toVec2(own.max - own.min)));
+			child->m_drawnarea = area;
+
+			if (child->clipping()) {
+				sf::FloatRect rect = states.transform.transformRect(sf::FloatRect(vec2(), child->size()));
+				if (!list.pushClip(rect)) {
+					// nothing of the child can be seen
+					continue;
 				}
-				// restore previous view state
-				getContext().setViewOffset(offset);
-				getContext().setClipRect(cliprect);
+				child->recordSubtree(list, states);
+				list.popClip();
+			} else {
+				child->recordSubtree(list, states);
 			}
 		}
 	}
 
-	Element::LayoutIndex Element::getNextLayoutIndex() const {
-		LayoutIndex max = 0.0f;
-		for (const auto& child : m_children) {
-			max = std::max(child->m_layoutindex, max);
-		}
-		for (const auto& space : m_whitespaces) {
-			max = std::max(space.layout_index, max);
+	void Element::recordSubtree(DrawList& list, sf::RenderStates states) {
+		if (m_cache && (m_cache->valid || updateCache())) {
+			sf::Sprite sprite(m_cache->texture.getTexture());
+			sprite.setPosition(m_cache->origin);
+			list.addSprite(sprite, states);
+		} else {
+			record(list, states);
+			recordChildren(list, states);
 		}
-		return max + 1.0f;
 	}
 
-	void Element::organizeLayoutIndices() {
-		using ElementOrSpace = std::pair<Ref<Element>, WhiteSpace*>;
-
-		std::set<std::pair<LayoutIndex, ElementOrSpace>> index_set;
-		for (const auto& child : m_children) {
-			index_set.insert({ child->m_layoutindex, {child, nullptr} });
-		}
-		for (auto& space : m_whitespaces) {
-			index_set.insert({ space.layout_index, {nullptr, &space} });
+	bool Element::updateCache() {
+		// clipping limits the bounds to the element's own rectangle
+		Bounds bounds = subtreeBounds();
+		vec2 origin(std::floor(bounds.min.x), std::floor(bounds.min.y));
+		sf::Vector2u texsize(
+			(unsigned)std::max(1.0f, std::ceil(bounds.max.x - origin.x)),
+			(unsigned)std::max(1.0f, std::ceil(bounds.max.y - origin.y))
+		);
+		if (m_cache->texture.getSize() != texsize && !m_cache->texture.create(texsize.x, texsize.y)) {
+			// too large for a texture, so it is drawn directly
+			return false;
 		}
+		m_cache->origin = origin;
+
+		DrawList& drawlist = m_cache->drawlist;
+		drawlist.clear(sf::FloatRect(0.0f, 0.0f, (float)texsize.x, (float)texsize.y));
+		sf::RenderStates states;
+		states.transform.translate(-origin);
+		record(drawlist, states);
+		recordChildren(drawlist, states);
+
+		m_cache->texture.clear(sf::Color::Transparent);
+		drawlist.draw(m_cache->texture);
+		m_cache->texture.display();
+		forgetDrawn();
+		m_cache->valid = true;
+		return true;
+	}
 
-		LayoutIndex i = 0.0f;
-		for (const auto& mapping : index_set) {
-			if (mapping.second.first) {
-				mapping.second.first->m_layoutindex = i;
-			} else if (mapping.second.second) {
-				mapping.second.second->layout_index = i;
+	void Element::forgetDrawn() {
+		for (const auto& child : m_children) {
+			if (child) {
+				child->m_drawn = false;
+				child->forgetDrawn();
 			}
-			i += 1.0f;
 		}
 	}
 
@@ -811,22 +1055,8 @@ namespace ui {
 		return false;
 	}
 
-	std::vector<std::pair<Ref<Element>, Element::WhiteSpace>> Element::sortChildrenByLayoutIndex() const {
-		std::vector<std::pair<Ref<Element>, Element::WhiteSpace>> sorted_elements;
-
-		sorted_elements.reserve(m_children.size() + m_whitespaces.size());
-
-		for (const auto& child : m_children) {
-			sorted_elements.push_back({ child, Element::WhiteSpace(Element::WhiteSpace::None, 0.0f) });
-		}
-		for (const auto& space : m_whitespaces) {
-			sorted_elements.push_back({ nullptr, space });
-		}
-
-		return sorted_elements;
-	}
-
 	const std::vector<Ref<Element>>& Element::children() const {
+		compactChildren();
 		return m_children;
 	}
 
@@ -843,8 +1073,12 @@ namespace ui {
 				if (mypar != otherpar) {
 					return;
 				}
-				m_layoutindex = sibling->m_layoutindex - 0.5f;
-				organizeLayoutIndices();
+				if (sibling.get() == this) {
+					return;
+				}
+				auto& sequence = mypar->m_layoutsequence;
+				sequence.splice(sibling->m_layoutslot, sequence, m_layoutslot);
+				mypar->makeDirty();
 			}
 		}
 	}
@@ -858,41 +1092,25 @@ namespace ui {
 				if (mypar != otherpar) {
 					return;
 				}
-				m_layoutindex = sibling->m_layoutindex + 0.5f;
-				organizeLayoutIndices();
+				if (sibling.get() == this) {
+					return;
+				}
+				auto& sequence = mypar->m_layoutsequence;
+				sequence.splice(std::next(sibling->m_layoutslot), sequence, m_layoutslot);
+				mypar->makeDirty();
 			}
 		}
 	}
 
-	void Element::setPadding(float _padding) {
-		if (abs(padding() - _padding) > epsilon) {
-			m_padding = std::max(_padding, 0.0f);
-			makeDirty();
-		}
-	}
-
-	float Element::padding() const {
-		return m_padding;
-	}
-
-	void Element::setMargin(float _margin) {
-		_margin = std::max(_margin, 0.0f);
-		if (abs(margin() - _margin) > epsilon) {
-			m_margin = _margin;
-			makeDirty();
-		}
-	}
-
-	float Element::margin() const {
-		return m_margin;
-	}
-
 	sf::Color Element::backgroundColor() const {
 		return m_displayrect.getFillColor();
 	}
 
 	void Element::setBackgroundColor(sf::Color color) {
-		m_displayrect.setFillColor(color);
+		if (m_displayrect.getFillColor() != color) {
+			m_displayrect.setFillColor(color);
+			repaint();
+		}
 	}
 
 	sf::Color Element::borderColor() const {
@@ -900,7 +1118,10 @@ namespace ui {
 	}
 
 	void Element::setBorderColor(sf::Color color) {
-		m_displayrect.setOutlineColor(color);
+		if (m_displayrect.getOutlineColor() != color) {
+			m_displayrect.setOutlineColor(color);
+			repaint();
+		}
 	}
 
 	float Element::borderRadius() const {
@@ -909,6 +1130,7 @@ namespace ui {
 
 	void Element::setBorderRadius(float radius) {
 		m_displayrect.setRadius(radius);
+		repaint();
 	}
 
 	float Element::borderThickness() const {
@@ -917,553 +1139,7 @@ namespace ui {
 
 	void Element::setBorderThickness(float thickness) {
 		m_displayrect.setOutlineThickness(std::max(0.0f, thickness));
-	}
-
-	void Element::updatePosition() {
-		if (layoutStyle() != LayoutStyle::Free) {
-			return;
-		}
-		auto par = parent().lock();
-		if (!par) {
-			return;
-		}
-		switch (xPositionStyle()) {
-			case PositionStyle::OutsideBegin:
-				m_pos.x = -xPositionSpacing() - width();
-				break;
-			case PositionStyle::InsideBegin:
-				m_pos.x = xPositionSpacing();
-				break;
-			case PositionStyle::Center:
-				m_pos.x = (par->width() - width()) * 0.5f;
-				break;
-			case PositionStyle::InsideEnd:
-				m_pos.x = par->width() - width() - xPositionSpacing();
-				break;
-			case PositionStyle::OutsideEnd:
-				m_pos.x = par->width() + xPositionSpacing();
-				break;
-		}
-		switch (yPositionStyle()) {
-			case PositionStyle::OutsideBegin:
-				m_pos.y = -yPositionSpacing() - height();
-				break;
-			case PositionStyle::InsideBegin:
-				m_pos.y = yPositionSpacing();
-				break;
-			case PositionStyle::Center:
-				m_pos.y = (par->height() - height()) * 0.5f;
-				break;
-			case PositionStyle::InsideEnd:
-				m_pos.y = par->height() - height() - yPositionSpacing();
-				break;
-			case PositionStyle::OutsideEnd:
-				m_pos.y = par->height() + yPositionSpacing();
-				break;
-		}
-	}
-
-	void Element::updateChildPositions() {
-		for (const auto& child : m_children) {
-			child->updatePosition();
-		}
-	}
-
-	void Element::makeDirty() {
-		m_isdirty = true;
-	}
-
-	bool Element::isDirty() const {
-		return m_isdirty;
-	}
-
-	void Element::makeClean() {
-		m_isdirty = false;
-	}
-
-	bool Element::update(float width_avail) {
-		if (this->layoutStyle() == LayoutStyle::Free) {
-			width_avail = width();
-		}
-		width_avail = std::min(std::max(width_avail, minWidth()), maxWidth());
-
-		if (layoutStyle() == LayoutStyle::Block) {
-			setWidth(width_avail);
-		}
-
-		if (!isDirty()) {
-			for (auto child = m_children.begin(); !isDirty() && child != m_children.end(); ++child) {
-				if ((*child)->update((*child)->width())) {
-					makeDirty();
-				}
-			}
-			if (!isDirty()) {
-				return false;
-			}
-		}
-
-		// calculate own width and arrange children
-		vec2 newsize = arrangeChildren(width_avail);
-		if (layoutStyle() == LayoutStyle::Block) {
-			newsize.x = std::max(width_avail, newsize.x);
-		}
-		m_size = vec2(
-			std::min(std::max(newsize.x, minWidth()), maxWidth()),
-			std::min(std::max(newsize.y, minHeight()), maxHeight())
-		);
-		if (width() > width_avail) {
-			newsize = arrangeChildren(width());
-			m_size = vec2(
-				std::min(std::max(newsize.x, minWidth()), maxWidth()),
-				std::min(std::max(newsize.y, minHeight()), maxHeight())
-			);
-		}
-		m_displayrect.setSize(size());
-		updatePosition();
-		updateChildPositions();
-		makeClean();
-
-		onResize();
-
-		if (this->layoutStyle() == LayoutStyle::Free) {
-			return false;
-		} else {
-			vec2 new_total_size = size() + vec2(2.0f * margin(), 2.0f * margin());
-			float diff = abs(m_oldtotalsize.x - new_total_size.x) + abs(m_oldtotalsize.y - new_total_size.y);
-			m_oldtotalsize = new_total_size;
-			return diff > epsilon;
-		}
-	}
-
-	struct LayoutData {
-
-		using Child = std::pair<Ref<Element>, Element::WhiteSpace>;
-
-		LayoutData(Element& _self, float _width_avail)
-			: self(_self),
-			width_avail(_width_avail) {
-
-			sorted_elements = self.sortChildrenByLayoutIndex();
-
-			reset();
-			auto comp = [](const Child& l, const Child& r) {
-				return (l.first ? l.first->m_layoutindex : l.second.layout_index) < (r.first ? r.first->m_layoutindex : r.second.layout_index);
-			};
-			std::sort(sorted_elements.begin(), sorted_elements.end(), comp);
-		}
-
-		const Element& self;
-		float width_avail;
-		vec2 contentsize;
-		float xpos;
-		float ypos;
-		float next_ypos;
-		float left_edge, right_edge;
-		bool emptyline;
-		std::vector<Child> sorted_elements;
-		std::vector<Ref<Element>> floatingleft, floatingright;
-
-		void reset() {
-			xpos = self.padding();
-			ypos = self.padding();
-			next_ypos = self.padding();
-			contentsize = { 2.0f * self.padding(), 2.0f * self.padding() };
-			left_edge = self.padding();
-			right_edge = width_avail - self.padding();
-			emptyline = true;
-		}
-
-		void layoutElements() {
-			std::vector<Ref<Element>> left_elems, right_elems;
-			std::vector<Child> inline_children;
-
-			auto horizontalAlign = [&, this](const std::vector<Ref<Element>>& line, float left_limit, float right_limit, bool full) {
-				if (line.size() == 0 || self.contentAlign() == ContentAlign::Left) {
-					return;
-				}
-
-				if (self.contentAlign() == ContentAlign::Right) {
-
-					float offset = right_limit - (line.back()->left() + line.back()->width() + line.back()->margin());
-					for (const auto& elem : line) {
-						elem->m_pos.x += offset;
-					}
-
-				} else if (self.contentAlign() == ContentAlign::Center) {
-
-					float width = line.back()->left() + line.back()->width() + line.back()->margin() - line.front()->left() - line.front()->margin();
-					float left_wanted = (width_avail - width) * 0.5f;
-					float left = std::min(std::max(left_wanted, left_limit), right_limit - width);
-					float offset = left - line.front()->left();
-
-					for (const auto& elem : line) {
-						elem->m_pos.x += offset;
-					}
-
-				} else if (self.contentAlign() == ContentAlign::Justify) {
-					if (line.size() <= 1 || !full) {
-						return;
-					}
-
-					float offset = (right_limit - (line.back()->left() + line.back()->width() + line.back()->margin())) / (float)(line.size() - 1);
-					float acc = 0;
-					for (const auto& elem : line) {
-						elem->m_pos.x += acc;
-						acc += offset;
-					}
-				}
-			};
-
-			// arranges and empties the current left- and right- floating elements
-			// and inline elements, returning the maximum width needed or the current
-			// available width if it would be exceeded without breaking onto a new line
-			auto layoutBatch = [&, this]() -> float {
-
-				// maximum natural size of left floating elements
-				float lwidth = 0.0f;
-
-				// maximum natural size of right floating elements
-				float rwidth = 0.0f;
-
-				// current size of inline elements
-				float iwidth_current = 0.0f;
-
-				// maximum size of inline elements
-				float iwidth = 0.0f;
-
-				// true if the available size is exceeded
-				bool exceeded_width = false;
-
-				// width of the largest element
-				float largest_width = 0.0f;
-
-				std::vector<Ref<Element>> line;
-
-				for (const auto& elem : left_elems) {
-					if (arrangeFloatingLeft(elem)) {
-						exceeded_width = true;
-					} else {
-						lwidth += elem->width() + 2.0f * elem->margin();
-					}
-					largest_width = std::max(largest_width, elem->width());
-				}
-				for (const auto& elem : right_elems) {
-					if (arrangeFloatingRight(elem)) {
-						exceeded_width = true;
-					} else {
-						lwidth += elem->width() + 2.0f * elem->margin();
-					}
-					largest_width = std::max(largest_width, elem->width());
-				}
-				for (const auto& child : inline_children) {
-					const Ref<Element>& elem = child.first;
-					float left = left_edge, right = right_edge;
-					if (elem) {
-						if (arrangeInline(elem)) {
-							horizontalAlign(line, left, right, true);
-							line.clear();
-							exceeded_width = true;
-						} else {
-							iwidth_current += elem->width() + 2.0f * elem->margin();
-						}
-						line.push_back(elem);
-						largest_width = std::max(largest_width, elem->width());
-					} else {
-						const Element::WhiteSpace& space = child.second;
-						if (space.type == Element::WhiteSpace::LineBreak) {
-							iwidth = std::max(iwidth, iwidth_current);
-							iwidth_current = 0.0f;
-							horizontalAlign(line, left, right, false);
-							line.clear();
-							if (emptyline) {
-								next_ypos += (float)space.charsize;
-								newLine();
-							} else {
-								newLine();
-							}
-						} else if (space.type == Element::WhiteSpace::Tab) {
-							iwidth_current += tab(space.charsize, left_edge);
-						}
-					}
-				}
-				horizontalAlign(line, left_edge, right_edge, false);
-				iwidth = std::max(iwidth, iwidth_current);
-				line.clear();
-				left_elems.clear();
-				right_elems.clear();
-				inline_children.clear();
-				if (exceeded_width) {
-					return std::max(this->width_avail, largest_width);
-				} else {
-					return lwidth + rwidth + iwidth + 2.0f * self.padding();
-				}
-			};
-
-			// arrange all elements in batches to fit within the available width,
-			// returning the maximum width needed without breaking lines
-			// or the available width if it would be exceeded
-			auto layoutEverything = [&, this]() -> float {
-				float max_width = 0.0f;
-				auto it = sorted_elements.cbegin();
-				auto end = sorted_elements.cend();
-				while (true) {
-					if (it == end) {
-						max_width = std::max(max_width, layoutBatch());
-						break;
-					}
-
-					Ref<Element> elem = it->first;
-
-					if (elem) {
-						// child element
-						if (elem->isVisible()) {
-							switch (elem->layoutStyle()) {
-								case LayoutStyle::Block:
-									max_width = std::max(max_width, layoutBatch());
-									arrangeBlock(elem);
-									break;
-								case LayoutStyle::Inline:
-									inline_children.push_back({ elem, Element::WhiteSpace(Element::WhiteSpace::None, 0.0f) });
-									break;
-								case LayoutStyle::FloatLeft:
-									left_elems.push_back(elem);
-									break;
-								case LayoutStyle::FloatRight:
-									right_elems.push_back(elem);
-									break;
-								default:
-									elem->update(far_away);
-									break;
-							}
-						}
-					} else {
-						// line break
-						const Element::WhiteSpace& br = it->second;
-						inline_children.push_back({ nullptr, br });
-					}
-
-					++it;
-				}
-
-				return max_width;
-			};
-
-			float max_width = layoutEverything();
-
-			bool should_shrink = self.layoutStyle() == LayoutStyle::Inline ||
-				self.layoutStyle() == LayoutStyle::FloatLeft ||
-				self.layoutStyle() == LayoutStyle::FloatRight;
-
-			if ((should_shrink && max_width < width_avail) || (max_width > width_avail && (max_width <= self.maxWidth()))) {
-				width_avail = max_width;
-				reset();
-				layoutEverything();
-			}
-		}
-
-		void arrangeBlock(const Ref<Element>& element) {
-			Element& elem = *element;
-
-			while (nextWiderLine()) {
-
-			}
-
-			elem.setPos({ self.padding() + elem.margin(), next_ypos + elem.margin() });
-			elem.update(right_edge - left_edge - 2.0f * elem.margin());
-			next_ypos = elem.top() + elem.height() + elem.margin();
-			fitContents(elem);
-			newLine();
-		}
-
-		// arranges an inline element adjacent to previous inline elements,
-		// flowing around floating elements.
-		// returns true if the available width was exceeded and the element
-		// broke onto a new line
-		bool arrangeInline(const Ref<Element>& element) {
-			Element& elem = *element;
-			bool broke_line = false;
-			do {
-				// position the element
-				elem.setPos({ xpos + elem.margin(), ypos + elem.margin() });
-				elem.update(right_edge - xpos - 2.0f * elem.margin() - self.padding());
-
-				if (elem.left() + elem.width() + elem.margin() > right_edge) {
-					broke_line = true;
-					// if it goes past the edge
-					if (emptyline) {
-						// if it's the only inline element on the line, find the next wider line
-						if (!nextWiderLine()) {
-							// if one doesn't exist
-							break;
-						}
-					} else {
-						// if other inline elements are on the line
-						newLine();
-					}
-				} else {
-					// if the element fits
-					break;
-				}
-
-			} while (true);
-
-			xpos = elem.left() + elem.width() + elem.margin();
-			next_ypos = std::max(next_ypos, elem.top() + elem.height() + elem.margin());
-			fitContents(elem);
-			emptyline = false;
-			return broke_line;
-		}
-
-		// arranges a left-floating element to the right of the left edge
-		// and any current left-floating elements.
-		// returns true if the available width was exceeded and the element
-		// broke onto a new line
-		bool arrangeFloatingLeft(const Ref<Element>& element) {
-			if (!emptyline) {
-				newLine();
-			}
-			Element& elem = *element;
-			bool broke_line = false;
-			do {
-				elem.setPos({ left_edge + elem.margin(), ypos + elem.margin() });
-				elem.update(right_edge - left_edge - 2.0f * elem.margin());
-				if (elem.left() + elem.width() + elem.padding() > right_edge) {
-					broke_line = true;
-					// if the element doesn't fit
-					if (!nextWiderLine()) {
-						// if a wider line can't be found
-						break;
-					}
-				} else {
-					// if the element fits
-					break;
-				}
-			} while (true);
-			floatingleft.push_back(element);
-			left_edge = getLeftEdge();
-			xpos = left_edge;
-			fitContents(elem);
-			return broke_line;
-		}
-
-		// arranges a right-floating element left of the right edge and any
-		// other current right-floating elements.
-		// return true if the available width was exceeded and the element
-		// broke onto a new line
-		bool arrangeFloatingRight(const Ref<Element>& element) {
-			Element& elem = *element;
-			bool broke_line = false;
-			do {
-				float avail = right_edge - left_edge - elem.margin() * 2.0f;
-				elem.update(avail);
-				if (elem.width() > avail) {
-					broke_line = true;
-					if (!nextWiderLine()) {
-						// if a wider line can't be found
-						break;
-					}
-				} else {
-					break;
-				}
-			} while (true);
-
-			elem.setPos({ right_edge - elem.width() - elem.margin(), ypos + elem.margin() });
-			floatingright.push_back(element);
-			right_edge = getRightEdge();
-			fitContents(elem);
-			return broke_line;
-		}
-
-		// adjusts `contentsize` to include the element
-		void fitContents(const Element& elem) {
-			contentsize = vec2(
-				std::max(contentsize.x, elem.left() + elem.width() + elem.margin() + self.padding()),
-				std::max(contentsize.y, elem.top() + elem.height() + elem.margin() + self.padding())
-			);
-		}
-
-		bool nextWiderLine() {
-			// if floating left elements, find next bottom edge of floating left and make newline there, return true
-			// else return false
-
-			if (floatingleft.size() > 0 || floatingright.size() > 0) {
-				float next_y = far_away;
-				for (const auto& elem : floatingleft) {
-					next_y = std::min(next_y, elem->top() + elem->height() + elem->margin());
-				}
-
-				for (const auto& elem : floatingright) {
-					next_y = std::min(next_y, elem->top() + elem->height() + elem->margin());
-				}
-
-				next_ypos = std::max(next_y, next_ypos);
-				newLine();
-				return true;
-			}
-
-			return false;
-		}
-
-		void newLine() {
-			ypos = next_ypos;
-
-			auto aboveNewLine = [=](const Ref<Element>& elem) {
-				return ypos >= elem->top() + elem->height() + elem->margin();
-			};
-
-			floatingleft.erase(
-				std::remove_if(floatingleft.begin(), floatingleft.end(), aboveNewLine),
-				floatingleft.end()
-			);
-
-			floatingright.erase(
-				std::remove_if(floatingright.begin(), floatingright.end(), aboveNewLine),
-				floatingright.end()
-			);
-
-			left_edge = getLeftEdge();
-			right_edge = getRightEdge();
-			xpos = left_edge;
-			emptyline = true;
-		}
-
-		float tab(unsigned charsize, float left) {
-			float tab_size = 50.0f * (float)charsize / 15.0f;
-			float nu_xpos = floor(((xpos - left) / tab_size) + 1.0f) * tab_size;
-			float diff = nu_xpos - (xpos - left);
-			xpos = nu_xpos + left;
-			return diff;
-		}
-
-		float getLeftEdge() const {
-			// Assumption: all elements in `floatingleft` pass through ypos
-			float extent = self.padding();
-			for (const auto& elem : floatingleft) {
-				extent = std::max(extent, elem->left() + elem->width() + elem->margin());
-			}
-			return extent;
-		}
-
-		float getRightEdge() const {
-			// Assumption: all elements in `floatingright` pass through ypos
-			float extent = width_avail - self.padding();
-			for (const auto& elem : floatingright) {
-				extent = std::min(extent, elem->left() - elem->margin());
-			}
-			return extent;
-		}
-	};
-
-	vec2 Element::arrangeChildren(float width_avail) {
-		if (m_children.size() == 0 && m_whitespaces.size() == 0) {
-			return { padding(), padding() };
-		}
-
-		LayoutData layout(*this, width_avail);
-
-		layout.layoutElements();
-
-		return layout.contentsize;
+		repaint();
 	}
 
 	FreeElement::FreeElement() : Element(LayoutStyle::Free) {
@@ -1486,9 +1162,13 @@ namespace ui {
 
 	}
 
-	Element::WhiteSpace::WhiteSpace(Element::WhiteSpace::Type _type, LayoutIndex _layout_index, unsigned _charsize)
-		: type(_type), layout_index(_layout_index), charsize(_charsize) {
+	FlexElement::FlexElement(FlexDirection direction) : Element(LayoutStyle::Flex) {
+		setFlexDirection(direction);
+	}
 
+	GridElement::GridElement(std::vector<GridTrack> columns) : Element(LayoutStyle::Grid) {
+		setGridColumns(std::move(columns));
 	}
 
+
 }
\ No newline at end of file
@@ -0,0 +1,102 @@
+#include "GUI/Glyphs.hpp"
+
+#include <cmath>
+
+namespace ui {
+
+	namespace {
+		void appendQuad(sf::VertexArray& vertices, sf::Color color, vec2 topleft, vec2 topright, vec2 bottomleft, vec2 bottomright, vec2 uv0, vec2 uv1) {
+			vertices.append(sf::Vertex(topleft, color, uv0));
+			vertices.append(sf::Vertex(topright, color, { uv1.x, uv0.y }));
+			vertices.append(sf::Vertex(bottomleft, color, { uv0.x, uv1.y }));
+			vertices.append(sf::Vertex(bottomleft, color, { uv0.x, uv1.y }));
+			vertices.append(sf::Vertex(topright, color, { uv1.x, uv0.y }));
+			vertices.append(sf::Vertex(bottomright, color, uv1));
+		}
+	}
+
+	bool hasStyle(TextStyle style, TextStyle flag) {
+		return (static_cast<uint32_t>(style) & static_cast<uint32_t>(flag)) != 0;
+	}
+
+	void appendGlyph(sf::VertexArray& vertices, sf::Color color, vec2 baseline, const sf::Glyph& glyph, float shear) {
+		float left = glyph.bounds.left;
+		float top = glyph.bounds.top;
+		float right = glyph.bounds.left + glyph.bounds.width;
+		float bottom = glyph.bounds.top + glyph.bounds.height;
+
+		vec2 uv0((float)glyph.textureRect.left, (float)glyph.textureRect.top);
+		vec2 uv1((float)(glyph.textureRect.left + glyph.textureRect.width), (float)(glyph.textureRect.top + glyph.textureRect.height));
+
+		appendQuad(vertices, color,
+			baseline + vec2(left - shear * top, top),
+			baseline + vec2(right - shear * top, top),
+			baseline + vec2(left - shear * bottom, bottom),
+			baseline + vec2(right - shear * bottom, bottom),
+			uv0, uv1
+		);
+	}
+
+	void appendLine(sf::VertexArray& vertices, sf::Color color, float left, float right, float y, float thickness) {
+		float top = std::floor(y - thickness * 0.5f + 0.5f);
+		float bottom = top + std::floor(thickness + 0.5f);
+		appendQuad(vertices, color, { left, top }, { right, top }, { left, bottom }, { right, bottom }, { 1.0f, 1.0f }, { 1.0f, 1.0f });
+	}
+
+	void appendString(sf::VertexArray& vertices, const sf::String& string, const sf::Font& font, unsigned charsize, TextStyle style, sf::Color color, vec2 origin) {
+		bool bold = hasStyle(style, TextStyle::Bold);
+		bool underlined = hasStyle(style, TextStyle::Underlined);
+		bool strikethrough = hasStyle(style, TextStyle::StrikeThrough);
+		float shear = hasStyle(style, TextStyle::Italic) ? italic_shear : 0.0f;
+		float thickness = font.getUnderlineThickness(charsize);
+		float underline = font.getUnderlinePosition(charsize);
+		const sf::FloatRect& xbounds = font.getGlyph(L'x', charsize, bold).bounds;
+		float strikeoffset = xbounds.top + xbounds.height * 0.5f;
+		float space_width = font.getGlyph(L' ', charsize, bold).advance;
+		float line_spacing = font.getLineSpacing(charsize);
+
+		// lines are underlined and struck through up to where they end
+		auto endLine = [&](vec2 baseline) {
+			if (underlined) {
+				appendLine(vertices, color, origin.x, baseline.x, baseline.y + underline, thickness);
+			}
+			if (strikethrough) {
+				appendLine(vertices, color, origin.x, baseline.x, baseline.y + strikeoffset, thickness);
+			}
+		};
+
+		vec2 baseline = origin + vec2(0.0f, (float)charsize);
+		sf::Uint32 prev = 0;
+		for (std::size_t i = 0; i < string.getSize(); ++i) {
+			sf::Uint32 ch = string[i];
+			if (ch == L'\r') {
+				continue;
+			}
+			baseline.x += font.getKerning(prev, ch, charsize);
+			if (ch == L'\n' && prev != L'\n') {
+				endLine(baseline);
+			}
+			prev = ch;
+
+			switch (ch) {
+				case L' ':
+					baseline.x += space_width;
+					continue;
+				case L'\t':
+					baseline.x += space_width * 4.0f;
+					continue;
+				case L'\n':
+					baseline.x = origin.x;
+					baseline.y += line_spacing;
+					continue;
+			}
+			const sf::Glyph& glyph = font.getGlyph(ch, charsize, bold);
+			appendGlyph(vertices, color, baseline, glyph, shear);
+			baseline.x += glyph.advance;
+		}
+		if (baseline.x > origin.x) {
+			endLine(baseline);
+		}
+	}
+
+} // namespace ui
@@ -10,6 +10,26 @@ namespace ui {
 
 	namespace {
 		Ref<Element> root_ptr;
+
+		// whether run() draws on a thread of its own
+		bool render_threaded = false;
+
+		// sleeping may overshoot by about this much, so the end of each wait is spun instead
+		const sf::Time frame_jitter = sf::milliseconds(2);
+
+		// longest time between frames while the window isn't focused
+		const sf::Time background_frame_delay = sf::milliseconds(100);
+
+		// waits until `deadline` on `clock`, sleeping for most of it
+		void waitUntil(const sf::Clock& clock, sf::Time deadline) {
+			sf::Time remaining = deadline - clock.getElapsedTime();
+			if (remaining > frame_jitter) {
+				sf::sleep(remaining - frame_jitter);
+			}
+			while (clock.getElapsedTime() < deadline) {
+				sf::sleep(sf::Time::Zero);
+			}
+		}
 	}
 
 	Element& root() {
@@ -59,11 +79,36 @@ namespace ui {
 		getContext().handleQuit(force);
 	}
 
+	void updateLayout(vec2 size) {
+		root().setSize(size, true);
+		root().layout(root().width());
+	}
+
+	bool layoutPending() {
+		return root().layoutPending();
+	}
+
+	unsigned long long skippedFrames() {
+		return getContext().getSkippedFrames();
+	}
+
+	void setRenderThread(bool enabled) {
+		render_threaded = enabled;
+	}
+
 	void run() {
-		float prev_time = getContext().getProgramTime();
+		sf::Clock frame_clock;
+		sf::Time next_frame = frame_clock.getElapsedTime();
+		bool focused = true;
+		bool idle = false;
 		while (getContext().getRenderWindow().isOpen() && !getContext().hasQuit()) {
+			// when nothing is changing, wait for something to happen
 			sf::Event event;
-			while (getContext().getRenderWindow().pollEvent(event)) {
+			bool has_event = idle ? getContext().getRenderWindow().waitEvent(event) : getContext().getRenderWindow().pollEvent(event);
+			if (idle) {
+				next_frame = frame_clock.getElapsedTime();
+			}
+			for (; has_event; has_event = getContext().getRenderWindow().pollEvent(event)) {
 				switch (event.type) {
 					case sf::Event::Closed:
 						quit();
@@ -74,6 +119,10 @@ namespace ui {
 					case sf::Event::LostFocus:
 						getContext().setDraggingElement(nullptr);
 						getContext().releaseAllButtons();
+						focused = false;
+						break;
+					case sf::Event::GainedFocus:
+						focused = true;
 						break;
 					case sf::Event::TextEntered:
 						if (auto text_entry = getContext().getTextEntry()) {
@@ -157,48 +206,39 @@ namespace ui {
 			getContext().applyTransitions();
 
 			// update elements
-			root().setSize(getScreenSize(), true);
-			root().update(root().width());
-
-			// clear the screen
-			getContext().getRenderWindow().clear();
-			getContext().resetView();
-
-			// render the root element, and all children it contains
-			root().renderChildren(getContext().getRenderWindow());
+			updateLayout(getScreenSize());
 
 			// highlight current element if alt is pressed
 			if ((sf::Keyboard::isKeyPressed(Key::LAlt) || sf::Keyboard::isKeyPressed(Key::RAlt))) {
 				getContext().highlightCurrentElement();
 			}
 
-			// highlight
-			if (auto curr = getContext().getCurrentElement()) {
-				float elapsed = getContext().timeSinceHighlight();
-
-				if (elapsed <= 2.0f) {
-					float value = exp(-elapsed * 3.453877f);
-					sf::Color color { 0xFFFF00FF };
-					color.a = (uint8_t)(std::min(value, 1.0f) * 255.0f);
-
-					sf::RectangleShape rect(curr->size());
-					rect.setPosition(curr->absPos());
-					rect.setFillColor(sf::Color(0));
-					rect.setOutlineColor(color);
-					rect.setOutlineThickness(2);
-					getContext().getRenderWindow().draw(rect);
-				}
+			// draw what changed, if anything did
+			if (render_threaded) {
+				getContext().startRenderThread();
+			} else {
+				getContext().stopRenderThread();
+			}
+			bool drawn = getContext().renderFrame();
+			idle = !drawn && !layoutPending() && !getContext().isAnimating();
+
+			// wait for the next frame, throttled in the background. Frames are kept on a fixed
+			// schedule, unless one is so late that catching up would mean rushing the next ones
+			sf::Time delay = sf::seconds(getContext().getRenderDelay());
+			if (!focused) {
+				delay = std::max(delay, background_frame_delay);
+			}
+			next_frame += delay;
+			if (next_frame < frame_clock.getElapsedTime()) {
+				next_frame = frame_clock.getElapsedTime();
+			}
+			if (!idle) {
+				waitUntil(frame_clock, next_frame);
 			}
-
-			getContext().getRenderWindow().display();
-
-			// sleep only as long as needed
-			float now = getContext().getProgramTime();
-			float delay = getContext().getRenderDelay();
-			sf::sleep(sf::seconds(std::max(0.0f, delay - now + prev_time)));
-			prev_time = now;
 		}
 
+		getContext().stopRenderThread();
+
 		// remove all windows from and close root
 		root().close();
 
@@ -28,6 +28,7 @@ void ui::Image::setAlpha(uint8_t alpha) {
 	sf::Color colormod = sprite.getColor();
 	colormod.a = alpha;
 	sprite.setColor(colormod);
+	repaint();
 }
 
 uint8_t ui::Image::getAlpha() const {
@@ -36,6 +37,7 @@ uint8_t ui::Image::getAlpha() const {
 
 void ui::Image::setColorMod(sf::Color color) {
 	sprite.setColor(color);
+	repaint();
 }
 
 sf::Color ui::Image::getColorMod() const {
@@ -60,6 +62,7 @@ bool ui::Image::setTexture(const Ref<sf::Texture>& _texture, bool auto_size) {
 		setSize({ (float)s.x, (float)s.y }, true);
 	}
 	sprite.setTexture(*texture);
+	repaint();
 	return true;
 }
 
@@ -70,6 +73,6 @@ void ui::Image::onResize() {
 	});
 }
 
-void ui::Image::render(sf::RenderWindow& rw) {
-	rw.draw(sprite);
+void ui::Image::record(DrawList& list, sf::RenderStates states) {
+	list.addSprite(sprite, states);
 }
@@ -0,0 +1,1943 @@
+#include "GUI/Layout.hpp"
+#include "GUI/ThreadPool.hpp"
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cmath>
+#include <map>
+#include <memory>
+#include <set>
+
+namespace ui {
+	namespace {
+		const float epsilon = 0.0001f;
+		const float far_away = 1000000.0f;
+
+		// number of layouts remembered per node
+		const std::size_t layout_cache_size = 4;
+
+		// while laying out on a worker thread, nodes that were resized
+		// are collected here instead of having onResize called on them
+		thread_local std::vector<LayoutNode*>* deferred_resizes = nullptr;
+
+		// the node a worker thread is laying out. Trails left by nodes skipped for lack
+		// of time stop there, since its parent is shared with the other jobs, and are
+		// continued by the thread that joins them
+		thread_local LayoutNode* job_root = nullptr;
+
+		// threads used for parallel layout, if enabled
+		std::unique_ptr<ThreadPool> layout_pool;
+
+		// time allowed for each layout, in microseconds, or 0 for no limit
+		std::atomic<unsigned> layout_budget { 0 };
+
+		// steady clock time, in nanoseconds, after which no more subtrees
+		// are started in the current layout, or 0 if there is no limit
+		std::atomic<long long> layout_deadline { 0 };
+
+		// true once the current layout finished laying out a node with children. Until
+		// then the deadline isn't enforced, so that every layout makes some progress
+		// even when walking to the first dirty node takes the whole budget
+		std::atomic<bool> layout_progressed { false };
+
+		// source of geometry generations, which only ever increase
+		std::atomic<std::uint64_t> geometry_generation { 0 };
+
+		long long nanosecondsNow() {
+			auto now = std::chrono::steady_clock::now().time_since_epoch();
+			return std::chrono::duration_cast<std::chrono::nanoseconds>(now).count();
+		}
+
+		bool pastLayoutDeadline() {
+			long long deadline = layout_deadline.load(std::memory_order_relaxed);
+			return deadline != 0 && layout_progressed.load(std::memory_order_relaxed) && nanosecondsNow() > deadline;
+		}
+
+		// true for styles placed on their own line, taking up the full width available
+		bool isBlockLike(LayoutStyle style) {
+			return style == LayoutStyle::Block || style == LayoutStyle::Flex || style == LayoutStyle::Grid;
+		}
+	}
+
+	void setLayoutThreads(unsigned threads) {
+		if (threads == 0) {
+			layout_pool = nullptr;
+		} else if (!layout_pool || layout_pool->size() != threads) {
+			layout_pool = std::make_unique<ThreadPool>(threads);
+		}
+	}
+
+	void setLayoutBudget(unsigned microseconds) {
+		layout_budget = microseconds;
+	}
+
+	unsigned layoutBudget() {
+		return layout_budget;
+	}
+
+	LayoutNode::LayoutNode(LayoutStyle style) :
+		m_layoutstyle(style),
+		m_contentalign(ContentAlign::Left),
+		m_visible(true),
+		m_pos({ 0.0f, 0.0f }),
+		m_size({ 100.0f, 100.0f }),
+		m_minsize({ 0.0f, 0.0f }),
+		m_maxsize({ far_away, far_away }),
+		m_oldtotalsize({ 0.0f, 0.0f }),
+		m_padding(0.0f),
+		m_margin(0.0f),
+		m_pstyle_x(PositionStyle::None),
+		m_pstyle_y(PositionStyle::None),
+		m_spacing_x(0.0f),
+		m_spacing_y(0.0f),
+		m_isdirty(true),
+		m_subtreedirty(false),
+		m_widthavail(0.0f),
+		m_boundsdirty(true),
+		m_changed(true),
+		m_relaidout(false),
+		m_geometrygeneration(++geometry_generation),
+		m_flexdirection(FlexDirection::Row),
+		m_flexwrap(false),
+		m_flexgap(0.0f),
+		m_flexgrow(0.0f),
+		m_flexshrink(1.0f),
+		m_assignedsize(-1.0f),
+		m_layoutgeneration(0),
+		m_layoutparent(nullptr) {
+
+	}
+
+	LayoutNode::~LayoutNode() {
+		if (m_layoutparent) {
+			m_layoutparent->m_layoutsequence.erase(m_layoutslot);
+		}
+		for (const auto& item : m_layoutsequence) {
+			if (item.node) {
+				item.node->m_layoutparent = nullptr;
+			}
+		}
+	}
+
+	void LayoutNode::layout(float width_avail) {
+		// nested layouts, such as from onResize, share the outermost one's deadline
+		unsigned budget = layout_budget;
+		bool timed = budget > 0 && layout_deadline == 0;
+		if (timed) {
+			layout_progressed = false;
+			layout_deadline = nanosecondsNow() + (long long)budget * 1000;
+		}
+		try {
+			update(width_avail);
+		} catch (...) {
+			if (timed) {
+				layout_deadline = 0;
+			}
+			throw;
+		}
+		if (timed) {
+			layout_deadline = 0;
+		}
+		// update() only marks the nodes it visits, not those above
+		if (m_boundsdirty || m_changed) {
+			markChanged();
+		}
+		LayoutNode* node = m_layoutparent;
+		while (node && node->m_geometrygeneration < m_geometrygeneration) {
+			node->m_geometrygeneration = m_geometrygeneration;
+			node = node->m_layoutparent;
+		}
+	}
+
+	bool LayoutNode::layoutPending() const {
+		return m_isdirty || m_subtreedirty;
+	}
+
+	Bounds LayoutNode::subtreeBounds() {
+		if (!m_boundsdirty) {
+			return m_subtreebounds;
+		}
+		Bounds bounds = ownBounds();
+		if (clipsDescendants()) {
+			bounds.min = Float2(std::max(bounds.min.x, 0.0f), std::max(bounds.min.y, 0.0f));
+			bounds.max = Float2(std::min(bounds.max.x, width()), std::min(bounds.max.y, height()));
+		} else {
+			for (const auto& item : m_layoutsequence) {
+				if (!item.node || !item.node->isVisible()) {
+					continue;
+				}
+				Bounds child = item.node->subtreeBounds();
+				Float2 pos = item.node->pos();
+				bounds.min = Float2(std::min(bounds.min.x, pos.x + child.min.x), std::min(bounds.min.y, pos.y + child.min.y));
+				bounds.max = Float2(std::max(bounds.max.x, pos.x + child.max.x), std::max(bounds.max.y, pos.y + child.max.y));
+			}
+		}
+		m_subtreebounds = bounds;
+		m_boundsdirty = false;
+		return bounds;
+	}
+
+	void LayoutNode::invalidateBounds() {
+		invalidateGeometry();
+		markChanged();
+	}
+
+	bool LayoutNode::hasChanges() const {
+		return m_changed;
+	}
+
+	void LayoutNode::markChanged() {
+		m_boundsdirty = true;
+		m_changed = true;
+		// the node itself may have been left marked while hidden, so the walk starts
+		// above it, and stops at the first ancestor already marked, since those
+		// above are marked too
+		LayoutNode* node = m_layoutparent;
+		while (node && !(node->m_boundsdirty && node->m_changed)) {
+			node->m_boundsdirty = true;
+			node->m_changed = true;
+			node = node->m_layoutparent;
+		}
+	}
+
+	std::uint64_t LayoutNode::geometryGeneration() const {
+		return m_geometrygeneration;
+	}
+
+	void LayoutNode::invalidateGeometry() {
+		std::uint64_t generation = ++geometry_generation;
+		for (LayoutNode* node = this; node; node = node->m_layoutparent) {
+			node->m_geometrygeneration = generation;
+		}
+	}
+
+	void LayoutNode::clearChanges() {
+		m_changed = false;
+		m_relaidout = false;
+	}
+
+	Bounds LayoutNode::ownBounds() const {
+		return { Float2(), size() };
+	}
+
+	bool LayoutNode::clipsDescendants() const {
+		return false;
+	}
+
+	void LayoutNode::appendChild(LayoutNode& child) {
+		if (child.m_layoutparent == this) {
+			return;
+		}
+		if (child.m_layoutparent) {
+			child.m_layoutparent->removeChild(child);
+		}
+		child.m_layoutparent = this;
+		child.m_layoutslot = m_layoutsequence.insert(m_layoutsequence.end(), { &child, WhiteSpace(WhiteSpace::None) });
+		childrenChanged();
+	}
+
+	void LayoutNode::removeChild(LayoutNode& child) {
+		if (child.m_layoutparent != this) {
+			return;
+		}
+		m_layoutsequence.erase(child.m_layoutslot);
+		child.m_layoutparent = nullptr;
+		makeDirty();
+	}
+
+	LayoutNode* LayoutNode::layoutParent() const {
+		return m_layoutparent;
+	}
+
+	void LayoutNode::setVisible(bool is_visible) {
+		if (isVisible() != is_visible) {
+			invalidateBounds();
+			if (layoutStyle() != LayoutStyle::Free) {
+				makeDirty();
+				if (m_layoutparent) {
+					m_layoutparent->makeDirty();
+				}
+			} else if (is_visible && (isDirty() || m_subtreedirty)) {
+				// changes made while hidden may not have reached the ancestors
+				makeAncestorsSubtreeDirty();
+			}
+		}
+		m_visible = is_visible;
+	}
+
+	bool LayoutNode::isVisible() const {
+		return m_visible;
+	}
+
+	Float2 LayoutNode::pos() const {
+		return m_pos;
+	}
+
+	float LayoutNode::left() const {
+		return m_pos.x;
+	}
+
+	float LayoutNode::top() const {
+		return m_pos.y;
+	}
+
+	void LayoutNode::setPos(Float2 _pos) {
+		if (std::abs(left() - _pos.x) + std::abs(top() - _pos.y) > epsilon) {
+			m_pos = _pos;
+			invalidateBounds();
+		}
+		if (m_layoutstyle == LayoutStyle::Free) {
+			updatePosition();
+		}
+	}
+
+	void LayoutNode::place(Float2 _pos) {
+		if (std::abs(left() - _pos.x) + std::abs(top() - _pos.y) > epsilon) {
+			m_pos = _pos;
+			m_boundsdirty = true;
+			m_changed = true;
+			m_geometrygeneration = ++geometry_generation;
+		}
+		if (m_layoutstyle == LayoutStyle::Free) {
+			updatePosition();
+		}
+	}
+
+	void LayoutNode::setLeft(float x) {
+		setPos({ x, top() });
+	}
+
+	void LayoutNode::setTop(float y) {
+		setPos({ left(), y });
+	}
+
+	Float2 LayoutNode::size() const {
+		return m_size;
+	}
+
+	void LayoutNode::setSize(Float2 _size, bool force) {
+		_size = Float2(std::max(_size.x, 0.0f), std::max(_size.y, 0.0f));
+		if (std::abs(width() - _size.x) + std::abs(height() - _size.y) > epsilon) {
+			m_size = _size;
+			invalidateBounds();
+			makeDirty();
+		}
+		if (force) {
+			if (minWidth() > width() || minHeight() > height() || maxWidth() < width() || maxHeight() < height()) {
+				makeDirty();
+			}
+			m_minsize = _size;
+			m_maxsize = _size;
+		}
+	}
+
+	void LayoutNode::setMinSize(Float2 _min_size) {
+		_min_size = Float2(std::max(_min_size.x, 0.0f), std::max(_min_size.y, 0.0f));
+		m_minsize = _min_size;
+		makeDirty();
+	}
+
+	Float2 LayoutNode::maxSize() const {
+		return m_maxsize;
+	}
+
+	Float2 LayoutNode::minSize() const {
+		return m_minsize;
+	}
+
+	void LayoutNode::setMinWidth(float width) {
+		setMinSize({ width, minHeight() });
+	}
+
+	void LayoutNode::setMinHeight(float height) {
+		setMinSize({ minWidth(), height });
+	}
+
+	void LayoutNode::setMaxSize(Float2 _max_size) {
+		_max_size = Float2(std::max(_max_size.x, 0.0f), std::max(_max_size.y, 0.0f));
+		m_maxsize = _max_size;
+		makeDirty();
+	}
+
+	void LayoutNode::setMaxWidth(float width) {
+		setMaxSize({ width, maxHeight() });
+	}
+
+	void LayoutNode::setWidth(float _width, bool force) {
+		_width = std::max(0.0f, _width);
+		if (std::abs(width() - _width) > epsilon) {
+			m_size.x = _width;
+			makeDirty();
+		}
+		if (force) {
+			if (width() < minWidth() || width() > maxWidth()) {
+				makeDirty();
+			}
+			m_minsize.x = _width;
+			m_maxsize.x = _width;
+		}
+	}
+
+	float LayoutNode::minWidth() const {
+		return m_minsize.x;
+	}
+
+	float LayoutNode::maxWidth() const {
+		return m_maxsize.x;
+	}
+
+	float LayoutNode::width() const {
+		return m_size.x;
+	}
+
+	void LayoutNode::setMaxHeight(float height) {
+		setMaxSize({ maxWidth(), height });
+	}
+
+	void LayoutNode::setHeight(float _height, bool force) {
+		_height = std::max(0.0f, _height);
+		if (std::abs(height() - _height) > epsilon) {
+			m_size.y = _height;
+			makeDirty();
+		}
+		if (force) {
+			if (height() < minHeight() || height() > maxHeight()) {
+				makeDirty();
+			}
+			m_minsize.y = _height;
+			m_maxsize.y = _height;
+		}
+	}
+
+	float LayoutNode::maxHeight() const {
+		return m_maxsize.y;
+	}
+
+	float LayoutNode::minHeight() const {
+		return m_minsize.y;
+	}
+
+	float LayoutNode::height() const {
+		return m_size.y;
+	}
+
+	void LayoutNode::onResize() {
+
+	}
+
+	void LayoutNode::setLayoutStyle(LayoutStyle style) {
+		if (layoutStyle() != style) {
+			m_layoutstyle = style;
+			if (m_layoutparent) {
+				m_layoutparent->makeDirty();
+			}
+		}
+	}
+
+	LayoutStyle LayoutNode::layoutStyle() const {
+		return m_layoutstyle;
+	}
+
+	void LayoutNode::setContentAlign(ContentAlign style) {
+		if (contentAlign() != style) {
+			m_contentalign = style;
+			makeDirty();
+		}
+	}
+
+	ContentAlign LayoutNode::contentAlign() const {
+		return m_contentalign;
+	}
+
+	void LayoutNode::setXPositionStyle(PositionStyle style, float spacing) {
+		m_pstyle_x = style;
+		m_spacing_x = spacing;
+	}
+
+	PositionStyle LayoutNode::xPositionStyle() const {
+		return m_pstyle_x;
+	}
+
+	float LayoutNode::xPositionSpacing() const {
+		return m_spacing_x;
+	}
+
+	void LayoutNode::setYPositionStyle(PositionStyle style, float spacing) {
+		m_pstyle_y = style;
+		m_spacing_y = spacing;
+	}
+
+	PositionStyle LayoutNode::yPositionStyle() const {
+		return m_pstyle_y;
+	}
+
+	float LayoutNode::yPositionSpacing() const {
+		return m_spacing_y;
+	}
+
+	void LayoutNode::setPadding(float _padding) {
+		if (std::abs(padding() - _padding) > epsilon) {
+			m_padding = std::max(_padding, 0.0f);
+			makeDirty();
+		}
+	}
+
+	float LayoutNode::padding() const {
+		return m_padding;
+	}
+
+	void LayoutNode::setMargin(float _margin) {
+		_margin = std::max(_margin, 0.0f);
+		if (std::abs(margin() - _margin) > epsilon) {
+			m_margin = _margin;
+			makeDirty();
+		}
+	}
+
+	float LayoutNode::margin() const {
+		return m_margin;
+	}
+
+	void LayoutNode::setFlexDirection(FlexDirection direction) {
+		if (flexDirection() != direction) {
+			m_flexdirection = direction;
+			makeDirty();
+		}
+	}
+
+	FlexDirection LayoutNode::flexDirection() const {
+		return m_flexdirection;
+	}
+
+	void LayoutNode::setFlexWrap(bool wrap) {
+		if (flexWrap() != wrap) {
+			m_flexwrap = wrap;
+			makeDirty();
+		}
+	}
+
+	bool LayoutNode::flexWrap() const {
+		return m_flexwrap;
+	}
+
+	void LayoutNode::setFlexGap(float gap) {
+		gap = std::max(gap, 0.0f);
+		if (std::abs(flexGap() - gap) > epsilon) {
+			m_flexgap = gap;
+			makeDirty();
+		}
+	}
+
+	float LayoutNode::flexGap() const {
+		return m_flexgap;
+	}
+
+	void LayoutNode::setFlexGrow(float grow) {
+		grow = std::max(grow, 0.0f);
+		if (std::abs(flexGrow() - grow) > epsilon) {
+			m_flexgrow = grow;
+			if (m_layoutparent) {
+				m_layoutparent->makeDirty();
+			}
+		}
+	}
+
+	float LayoutNode::flexGrow() const {
+		return m_flexgrow;
+	}
+
+	void LayoutNode::setFlexShrink(float shrink) {
+		shrink = std::max(shrink, 0.0f);
+		if (std::abs(flexShrink() - shrink) > epsilon) {
+			m_flexshrink = shrink;
+			if (m_layoutparent) {
+				m_layoutparent->makeDirty();
+			}
+		}
+	}
+
+	float LayoutNode::flexShrink() const {
+		return m_flexshrink;
+	}
+
+	bool LayoutNode::fillsWidth() const {
+		if (isBlockLike(layoutStyle())) {
+			return true;
+		}
+		return hasAssignedSize() && (m_layoutparent->layoutStyle() == LayoutStyle::Grid || m_layoutparent->flexDirection() == FlexDirection::Row);
+	}
+
+	bool LayoutNode::hasAssignedSize() const {
+		return m_assignedsize >= 0.0f && m_layoutparent &&
+			(m_layoutparent->layoutStyle() == LayoutStyle::Flex || m_layoutparent->layoutStyle() == LayoutStyle::Grid);
+	}
+
+	LayoutNode::GridData& LayoutNode::grid() {
+		if (!m_grid) {
+			m_grid = std::make_unique<GridData>();
+		}
+		return *m_grid;
+	}
+
+	void LayoutNode::setGridColumns(std::vector<GridTrack> columns) {
+		grid().columns = std::move(columns);
+		makeDirty();
+	}
+
+	const std::vector<GridTrack>& LayoutNode::gridColumns() const {
+		static const std::vector<GridTrack> none;
+		return m_grid ? m_grid->columns : none;
+	}
+
+	void LayoutNode::setGridRows(std::vector<GridTrack> rows) {
+		grid().rows = std::move(rows);
+		makeDirty();
+	}
+
+	const std::vector<GridTrack>& LayoutNode::gridRows() const {
+		static const std::vector<GridTrack> none;
+		return m_grid ? m_grid->rows : none;
+	}
+
+	void LayoutNode::setGridGap(float gap) {
+		gap = std::max(gap, 0.0f);
+		if (std::abs(gridGap() - gap) > epsilon) {
+			grid().gap = gap;
+			makeDirty();
+		}
+	}
+
+	float LayoutNode::gridGap() const {
+		return m_grid ? m_grid->gap : 0.0f;
+	}
+
+	const std::vector<float>& LayoutNode::gridColumnSizes() const {
+		static const std::vector<float> none;
+		return m_grid ? m_grid->column_sizes : none;
+	}
+
+	const std::vector<float>& LayoutNode::gridRowSizes() const {
+		static const std::vector<float> none;
+		return m_grid ? m_grid->row_sizes : none;
+	}
+
+	void LayoutNode::setGridCell(unsigned row, unsigned column, unsigned row_span, unsigned column_span) {
+		m_gridcell.row = row;
+		m_gridcell.column = column;
+		m_gridcell.row_span = std::max(row_span, 1u);
+		m_gridcell.column_span = std::max(column_span, 1u);
+		m_gridcell.placed = true;
+		if (m_layoutparent) {
+			m_layoutparent->makeDirty();
+		}
+	}
+
+	void LayoutNode::clearGridCell() {
+		if (m_gridcell.placed) {
+			m_gridcell = GridCell();
+			if (m_layoutparent) {
+				m_layoutparent->makeDirty();
+			}
+		}
+	}
+
+	void LayoutNode::writeLineBreak(unsigned charsize) {
+		m_layoutsequence.push_back({ nullptr, WhiteSpace(WhiteSpace::LineBreak, charsize) });
+		makeDirty();
+	}
+
+	void LayoutNode::writeTab(float width) {
+		unsigned charsize = static_cast<unsigned>(std::floor(width / 50.0f * 15.0f));
+		m_layoutsequence.push_back({ nullptr, WhiteSpace(WhiteSpace::Tab, charsize) });
+		makeDirty();
+	}
+
+	InlineBox* LayoutNode::inlineBoxes(std::size_t, std::size_t& count) {
+		count = 0;
+		return nullptr;
+	}
+
+	void LayoutNode::childrenChanged() {
+		invalidateGeometry();
+		makeDirty();
+		if (layoutStyle() != LayoutStyle::Free && m_layoutparent) {
+			m_layoutparent->makeDirty();
+		}
+	}
+
+	void LayoutNode::updatePosition() {
+		if (layoutStyle() != LayoutStyle::Free) {
+			return;
+		}
+		LayoutNode* par = m_layoutparent;
+		if (!par) {
+			return;
+		}
+		switch (xPositionStyle()) {
+			case PositionStyle::OutsideBegin:
+				m_pos.x = -xPositionSpacing() - width();
+				break;
+			case PositionStyle::InsideBegin:
+				m_pos.x = xPositionSpacing();
+				break;
+			case PositionStyle::Center:
+				m_pos.x = (par->width() - width()) * 0.5f;
+				break;
+			case PositionStyle::InsideEnd:
+				m_pos.x = par->width() - width() - xPositionSpacing();
+				break;
+			case PositionStyle::OutsideEnd:
+				m_pos.x = par->width() + xPositionSpacing();
+				break;
+		}
+		switch (yPositionStyle()) {
+			case PositionStyle::OutsideBegin:
+				m_pos.y = -yPositionSpacing() - height();
+				break;
+			case PositionStyle::InsideBegin:
+				m_pos.y = yPositionSpacing();
+				break;
+			case PositionStyle::Center:
+				m_pos.y = (par->height() - height()) * 0.5f;
+				break;
+			case PositionStyle::InsideEnd:
+				m_pos.y = par->height() - height() - yPositionSpacing();
+				break;
+			case PositionStyle::OutsideEnd:
+				m_pos.y = par->height() + yPositionSpacing();
+				break;
+		}
+	}
+
+	void LayoutNode::updateChildPositions() {
+		for (const auto& item : m_layoutsequence) {
+			if (item.node) {
+				item.node->updatePosition();
+			}
+		}
+	}
+
+	void LayoutNode::makeDirty() {
+		m_isdirty = true;
+		++m_layoutgeneration;
+		makeAncestorsSubtreeDirty();
+	}
+
+	void LayoutNode::makeAncestorsSubtreeDirty() {
+		// stop at the first ancestor already marked, since its own ancestors
+		// are either marked too or are being updated and will visit it
+		LayoutNode* node = this;
+		while (node != job_root && node->m_layoutparent && !node->m_layoutparent->m_subtreedirty) {
+			node = node->m_layoutparent;
+			node->m_subtreedirty = true;
+		}
+	}
+
+	bool LayoutNode::isDirty() const {
+		return m_isdirty;
+	}
+
+	void LayoutNode::makeClean() {
+		m_isdirty = false;
+	}
+
+	bool LayoutNode::update(float width_avail) {
+		m_widthavail = width_avail;
+
+		if (this->layoutStyle() == LayoutStyle::Free) {
+			width_avail = width();
+		}
+		width_avail = std::min(std::max(width_avail, minWidth()), maxWidth());
+
+		bool resized = fillsWidth() && std::abs(width() - width_avail) > epsilon;
+
+		if (!resized && !isDirty() && !m_subtreedirty) {
+			// nothing changed in this subtree
+			return false;
+		}
+
+		// being resized by the parent doesn't invalidate cached layouts,
+		// since those are keyed by width
+		auto resize = [&] {
+			m_size.x = width_avail;
+			m_isdirty = true;
+			m_boundsdirty = true;
+			m_changed = true;
+		};
+
+		// nodes without children are as quick to lay out as to skip
+		if (!m_layoutsequence.empty() && pastLayoutDeadline()) {
+			// out of time: children keep their previous arrangement, and a trail is left
+			// for the next layout, since ancestors cleared theirs. The width given by the
+			// parent is still taken, like the position, since a node left wider than its
+			// parent would widen the parent and have its finished siblings laid out again
+			if (resized) {
+				resize();
+			}
+			makeAncestorsSubtreeDirty();
+			return false;
+		}
+
+		if (resized) {
+			resize();
+		}
+
+		// the flag is cleared before visiting children so that any changes
+		// made while updating will mark this element again
+		m_subtreedirty = false;
+
+		if (!isDirty()) {
+			for (auto item = m_layoutsequence.begin(); !isDirty() && item != m_layoutsequence.end(); ++item) {
+				if (item->node && item->node->update(item->node->width())) {
+					// the parent is already being updated, no need to mark ancestors
+					m_isdirty = true;
+					++m_layoutgeneration;
+				}
+				if (item->node && (item->node->m_boundsdirty || item->node->m_changed)) {
+					// nodes being updated only mark themselves, to stay out of
+					// each other's way while laid out in parallel
+					m_boundsdirty = true;
+					m_changed = true;
+				}
+				if (item->node) {
+					m_geometrygeneration = std::max(m_geometrygeneration, item->node->m_geometrygeneration);
+				}
+			}
+			if (!isDirty()) {
+				return false;
+			}
+		}
+
+		// calculate own width and arrange children
+		Float2 newsize = arrangeChildren(width_avail);
+		if (fillsWidth()) {
+			newsize.x = std::max(width_avail, newsize.x);
+		}
+		m_size = Float2(
+			std::min(std::max(newsize.x, minWidth()), maxWidth()),
+			std::min(std::max(newsize.y, minHeight()), maxHeight())
+		);
+		if (width() > width_avail) {
+			newsize = arrangeChildren(width());
+			m_size = Float2(
+				std::min(std::max(newsize.x, minWidth()), maxWidth()),
+				std::min(std::max(newsize.y, minHeight()), maxHeight())
+			);
+		}
+		if (hasAssignedSize() && m_layoutparent->flexDirection() == FlexDirection::Column) {
+			// stretched or shrunk along a column
+			m_size.y = std::min(std::max(m_assignedsize, minHeight()), maxHeight());
+		}
+		updatePosition();
+		updateChildPositions();
+		makeClean();
+		m_boundsdirty = true;
+		m_changed = true;
+		m_relaidout = true;
+		m_geometrygeneration = ++geometry_generation;
+		if (!m_layoutsequence.empty() && !layout_progressed.load(std::memory_order_relaxed)) {
+			layout_progressed.store(true, std::memory_order_relaxed);
+		}
+
+		if (deferred_resizes) {
+			deferred_resizes->push_back(this);
+		} else {
+			onResize();
+		}
+
+		if (this->layoutStyle() == LayoutStyle::Free) {
+			return false;
+		} else {
+			Float2 new_total_size = size() + Float2(2.0f * margin(), 2.0f * margin());
+			float diff = std::abs(m_oldtotalsize.x - new_total_size.x) + std::abs(m_oldtotalsize.y - new_total_size.y);
+			m_oldtotalsize = new_total_size;
+			return diff > epsilon;
+		}
+	}
+
+	struct LayoutData {
+
+		using Child = LayoutNode::LayoutItem;
+
+		LayoutData(LayoutNode& _self, float _width_avail)
+			: self(_self),
+			width_avail(_width_avail),
+			sorted_elements(_self.m_layoutsequence) {
+
+			reset();
+		}
+
+		LayoutNode& self;
+		float width_avail;
+		Float2 contentsize;
+		float xpos;
+		float ypos;
+		float next_ypos;
+		float left_edge, right_edge;
+		bool emptyline;
+		// the parent's own sequence, which must not be modified during layout
+		const std::list<Child>& sorted_elements;
+
+		// the floating elements on one side which the current line passes through,
+		// ordered by bottom edge so that those above a new line expire in log time
+		struct FloatEdges {
+			// outer edge of each float, keyed by its bottom edge
+			std::multimap<float, float> by_bottom;
+			// the same outer edges, ordered
+			std::multiset<float> extents;
+
+			void add(float bottom, float extent) {
+				by_bottom.insert({ bottom, extent });
+				extents.insert(extent);
+			}
+
+			// removes floats ending at or above `y`
+			void expireAbove(float y) {
+				auto end = by_bottom.upper_bound(y);
+				for (auto it = by_bottom.begin(); it != end; ++it) {
+					extents.erase(extents.find(it->second));
+				}
+				by_bottom.erase(by_bottom.begin(), end);
+			}
+
+			// the highest bottom edge of any float
+			float nextBottom() const {
+				return by_bottom.empty() ? far_away : by_bottom.begin()->first;
+			}
+
+			bool empty() const {
+				return by_bottom.empty();
+			}
+
+			void clear() {
+				by_bottom.clear();
+				extents.clear();
+			}
+		};
+
+		FloatEdges floatingleft, floatingright;
+
+		void reset() {
+			floatingleft.clear();
+			floatingright.clear();
+			xpos = self.padding();
+			ypos = self.padding();
+			next_ypos = self.padding();
+			contentsize = { 2.0f * self.padding(), 2.0f * self.padding() };
+			left_edge = self.padding();
+			right_edge = width_avail - self.padding();
+			emptyline = true;
+		}
+
+		// an inline node or an inline box of a run of text, on the current line
+		struct LineItem {
+			LayoutNode* node;
+			InlineBox* box;
+
+			// left edge, including the margin
+			float outerLeft() const {
+				return node ? node->left() - node->margin() : box->pos.x;
+			}
+
+			// right edge, including the margin
+			float outerRight() const {
+				return node ? node->left() + node->width() + node->margin() : box->pos.x + box->width;
+			}
+
+			void shift(float offset) {
+				if (node) {
+					node->m_pos.x += offset;
+				} else {
+					box->pos.x += offset;
+				}
+			}
+		};
+
+		void layoutElements() {
+			if (self.layoutStyle() == LayoutStyle::Flex) {
+				layoutFlex();
+				return;
+			}
+			if (self.layoutStyle() == LayoutStyle::Grid) {
+				layoutGrid();
+				return;
+			}
+
+			std::vector<LayoutNode*> left_elems, right_elems;
+			std::vector<Child> inline_children;
+
+			auto horizontalAlign = [&, this](std::vector<LineItem>& line, float left_limit, float right_limit, bool full) {
+				if (line.size() == 0 || self.contentAlign() == ContentAlign::Left) {
+					return;
+				}
+
+				if (self.contentAlign() == ContentAlign::Right) {
+
+					float offset = right_limit - line.back().outerRight();
+					for (auto& item : line) {
+						item.shift(offset);
+					}
+
+				} else if (self.contentAlign() == ContentAlign::Center) {
+
+					float width = line.back().outerRight() - line.front().outerLeft();
+					float left_wanted = (width_avail - width) * 0.5f;
+					float left = std::min(std::max(left_wanted, left_limit), right_limit - width);
+					float offset = left - line.front().outerLeft();
+
+					for (auto& item : line) {
+						item.shift(offset);
+					}
+
+				} else if (self.contentAlign() == ContentAlign::Justify) {
+					if (line.size() <= 1 || !full) {
+						return;
+					}
+
+					float offset = (right_limit - line.back().outerRight()) / (float)(line.size() - 1);
+					float acc = 0;
+					for (auto& item : line) {
+						item.shift(acc);
+						acc += offset;
+					}
+				}
+			};
+
+			// arranges and empties the current left- and right- floating elements
+			// and inline elements, returning the maximum width needed or the current
+			// available width if it would be exceeded without breaking onto a new line
+			auto layoutBatch = [&, this]() -> float {
+
+				// maximum natural size of left floating elements
+				float lwidth = 0.0f;
+
+				// maximum natural size of right floating elements
+				float rwidth = 0.0f;
+
+				// current size of inline elements
+				float iwidth_current = 0.0f;
+
+				// advance of the last inline box, counted once something follows it
+				float iwidth_advance = 0.0f;
+
+				// maximum size of inline elements
+				float iwidth = 0.0f;
+
+				// true if the available size is exceeded
+				bool exceeded_width = false;
+
+				// width of the largest element
+				float largest_width = 0.0f;
+
+				std::vector<LineItem> line;
+
+				for (const auto& elem : left_elems) {
+					if (arrangeFloatingLeft(elem)) {
+						exceeded_width = true;
+					} else {
+						lwidth += elem->width() + 2.0f * elem->margin();
+					}
+					largest_width = std::max(largest_width, elem->width());
+				}
+				for (const auto& elem : right_elems) {
+					if (arrangeFloatingRight(elem)) {
+						exceeded_width = true;
+					} else {
+						lwidth += elem->width() + 2.0f * elem->margin();
+					}
+					largest_width = std::max(largest_width, elem->width());
+				}
+				for (const auto& child : inline_children) {
+					LayoutNode* elem = child.node;
+					float left = left_edge, right = right_edge;
+					if (elem) {
+						if (arrangeInline(elem)) {
+							horizontalAlign(line, left, right, true);
+							line.clear();
+							exceeded_width = true;
+						} else {
+							iwidth_current += iwidth_advance + elem->width() + 2.0f * elem->margin();
+						}
+						iwidth_advance = 0.0f;
+						line.push_back({ elem, nullptr });
+						largest_width = std::max(largest_width, elem->width());
+					} else {
+						const LayoutNode::WhiteSpace& space = child.space;
+						if (space.type == LayoutNode::WhiteSpace::Text) {
+							std::size_t count = 0;
+							InlineBox* boxes = self.inlineBoxes(space.run, count);
+							for (std::size_t i = 0; i < count; ++i) {
+								InlineBox& box = boxes[i];
+								left = left_edge;
+								right = right_edge;
+								if (arrangeBox(box)) {
+									horizontalAlign(line, left, right, true);
+									line.clear();
+									exceeded_width = true;
+								} else {
+									iwidth_current += iwidth_advance + box.width;
+								}
+								iwidth_advance = box.advance;
+								line.push_back({ nullptr, &box });
+								largest_width = std::max(largest_width, box.width);
+							}
+						} else if (space.type == LayoutNode::WhiteSpace::LineBreak) {
+							iwidth = std::max(iwidth, iwidth_current);
+							iwidth_current = 0.0f;
+							iwidth_advance = 0.0f;
+							horizontalAlign(line, left, right, false);
+							line.clear();
+							if (emptyline) {
+								next_ypos += (float)space.charsize;
+								newLine();
+							} else {
+								newLine();
+							}
+						} else if (space.type == LayoutNode::WhiteSpace::Tab) {
+							iwidth_current += iwidth_advance + tab(space.charsize, left_edge);
+							iwidth_advance = 0.0f;
+						}
+					}
+				}
+				horizontalAlign(line, left_edge, right_edge, false);
+				iwidth = std::max(iwidth, iwidth_current);
+				line.clear();
+				left_elems.clear();
+				right_elems.clear();
+				inline_children.clear();
+				if (exceeded_width) {
+					return std::max(this->width_avail, largest_width);
+				} else {
+					return lwidth + rwidth + iwidth + 2.0f * self.padding();
+				}
+			};
+
+			// arrange all elements in batches to fit within the available width,
+			// returning the maximum width needed without breaking lines
+			// or the available width if it would be exceeded
+			auto layoutEverything = [&, this]() -> float {
+				float max_width = 0.0f;
+				auto it = sorted_elements.cbegin();
+				auto end = sorted_elements.cend();
+				while (true) {
+					if (it == end) {
+						max_width = std::max(max_width, layoutBatch());
+						break;
+					}
+
+					LayoutNode* elem = it->node;
+
+					if (elem) {
+						// child element
+						if (elem->isVisible()) {
+							switch (elem->layoutStyle()) {
+								case LayoutStyle::Block:
+								case LayoutStyle::Flex:
+								case LayoutStyle::Grid:
+									max_width = std::max(max_width, layoutBatch());
+									arrangeBlock(elem);
+									break;
+								case LayoutStyle::Inline:
+									inline_children.push_back(*it);
+									break;
+								case LayoutStyle::FloatLeft:
+									left_elems.push_back(elem);
+									break;
+								case LayoutStyle::FloatRight:
+									right_elems.push_back(elem);
+									break;
+								default:
+									elem->update(far_away);
+									break;
+							}
+						}
+					} else {
+						// line break
+						inline_children.push_back(*it);
+					}
+
+					++it;
+				}
+
+				return max_width;
+			};
+
+			updateIndependentChildren();
+
+			float max_width = layoutEverything();
+
+			bool should_shrink = self.layoutStyle() == LayoutStyle::Inline ||
+				self.layoutStyle() == LayoutStyle::FloatLeft ||
+				self.layoutStyle() == LayoutStyle::FloatRight;
+
+			if ((should_shrink && max_width < width_avail) || (max_width > width_avail && (max_width <= self.maxWidth()))) {
+				width_avail = max_width;
+				reset();
+				layoutEverything();
+			}
+		}
+
+		// a child of a Flex node, with its outer size including margins
+		struct FlexItem {
+			LayoutNode* node;
+			float main;
+			float cross;
+		};
+
+		// arranges children along rows or columns in one pass. Each child is measured
+		// at its natural size, which is remembered until it changes, and laid out again
+		// only if free space or overflow in its row or column gives it a new size
+		void layoutFlex() {
+			const bool row = self.flexDirection() == FlexDirection::Row;
+			const float gap = self.flexGap();
+			const float inner_width = width_avail - 2.0f * self.padding();
+
+			// the space along the main axis which growing children fill
+			const float main_fill = row ? inner_width : self.minHeight() - 2.0f * self.padding();
+			// the space along the main axis beyond which children wrap or shrink
+			const float main_limit = row ? inner_width : self.maxHeight() - 2.0f * self.padding();
+
+			std::vector<FlexItem> line;
+			float line_main = 0.0f;
+			float cross_pos = self.padding();
+			float max_main = 0.0f;
+
+			auto outerMain = [row](const LayoutNode& node) {
+				return (row ? node.width() : node.height()) + 2.0f * node.margin();
+			};
+			auto outerCross = [row](const LayoutNode& node) {
+				return (row ? node.height() : node.width()) + 2.0f * node.margin();
+			};
+
+			auto finishLine = [&, this]() {
+				if (line.empty()) {
+					return;
+				}
+
+				// grow into free space, or shrink in proportion to size if overflowing
+				float free = 0.0f;
+				if (line_main > main_limit) {
+					free = main_limit - line_main;
+				} else if (line_main < main_fill) {
+					free = main_fill - line_main;
+				}
+				float total_factor = 0.0f;
+				for (const auto& item : line) {
+					total_factor += free > 0.0f ? item.node->flexGrow() : item.node->flexShrink() * item.main;
+				}
+				for (auto& item : line) {
+					LayoutNode& node = *item.node;
+					float factor = free > 0.0f ? node.flexGrow() : node.flexShrink() * item.main;
+					float size = -1.0f;
+					if (free != 0.0f && total_factor > 0.0f && factor > 0.0f) {
+						size = std::max(item.main + free * factor / total_factor - 2.0f * node.margin(), 0.0f);
+					}
+					// children are only laid out again if the size they were given changed,
+					// since they were measured from the cache and may still have their old size.
+					// A new width along a row is noticed by update() itself
+					bool resized = std::abs(node.m_assignedsize - size) > epsilon;
+					if (resized) {
+						node.m_assignedsize = size;
+						if (!row || size < 0.0f) {
+							node.m_isdirty = true;
+						}
+					}
+					if (resized || size >= 0.0f) {
+						node.update(row && size >= 0.0f ? size : inner_width - 2.0f * node.margin());
+						item.main = outerMain(node);
+						item.cross = outerCross(node);
+					}
+				}
+
+				float used = (float)(line.size() - 1) * gap;
+				float line_cross = 0.0f;
+				for (const auto& item : line) {
+					used += item.main;
+					line_cross = std::max(line_cross, item.cross);
+				}
+
+				// distribute what is left according to the content alignment
+				float remaining = std::max((row ? inner_width : main_fill) - used, 0.0f);
+				float main_pos = self.padding();
+				float spacing = gap;
+				switch (self.contentAlign()) {
+					case ContentAlign::Right:
+						main_pos += remaining;
+						break;
+					case ContentAlign::Center:
+						main_pos += remaining * 0.5f;
+						break;
+					case ContentAlign::Justify:
+						if (line.size() > 1) {
+							spacing += remaining / (float)(line.size() - 1);
+						}
+						break;
+					default:
+						break;
+				}
+
+				for (const auto& item : line) {
+					LayoutNode& node = *item.node;
+					if (row) {
+						node.place({ main_pos + node.margin(), cross_pos + node.margin() });
+					} else {
+						node.place({ cross_pos + node.margin(), main_pos + node.margin() });
+					}
+					main_pos += item.main + spacing;
+				}
+				max_main = std::max(max_main, main_pos - spacing - self.padding());
+				cross_pos += line_cross + gap;
+
+				line.clear();
+				line_main = 0.0f;
+			};
+
+			for (const auto& child : sorted_elements) {
+				LayoutNode* elem = child.node;
+				if (!elem || !elem->isVisible()) {
+					continue;
+				}
+				if (elem->layoutStyle() == LayoutStyle::Free) {
+					elem->update(far_away);
+					continue;
+				}
+
+				// measure at the natural size, which is remembered until the child changes
+				Float2 natural = measureNatural(*elem, inner_width);
+				float margins = 2.0f * elem->margin();
+				FlexItem item { elem, (row ? natural.x : natural.y) + margins, (row ? natural.y : natural.x) + margins };
+				float needed = line_main + (line.empty() ? 0.0f : gap) + item.main;
+				if (self.flexWrap() && !line.empty() && needed > main_limit) {
+					finishLine();
+					needed = item.main;
+				}
+				line.push_back(item);
+				line_main = needed;
+			}
+			finishLine();
+
+			float cross_size = cross_pos - (cross_pos > self.padding() ? gap : 0.0f) + self.padding();
+			float main_size = max_main + 2.0f * self.padding();
+			contentsize = row ? Float2(main_size, cross_size) : Float2(cross_size, main_size);
+		}
+
+		// a child of a Grid node and the tracks it spans
+		struct GridItem {
+			LayoutNode* node;
+			std::size_t row, column, row_span, column_span;
+		};
+
+		// arranges children in the cells of the grid's tracks. Only children in Auto
+		// columns are measured at their natural width, which is remembered until they
+		// change, so that a change to one cell doesn't remeasure the others
+		void layoutGrid() {
+			LayoutNode::GridData& grid = self.grid();
+			const float gap = grid.gap;
+			const float inner_width = width_avail - 2.0f * self.padding();
+			const std::size_t columns = std::max<std::size_t>(grid.columns.size(), 1);
+
+			auto columnTrack = [&](std::size_t i) {
+				return i < grid.columns.size() ? grid.columns[i] : GridTrack(GridTrack::Fraction, 1.0f);
+			};
+			auto rowTrack = [&](std::size_t i) {
+				return i < grid.rows.size() ? grid.rows[i] : GridTrack(GridTrack::Auto);
+			};
+
+			// place children, first those given a cell and then the rest in order
+			std::vector<GridItem> items;
+			std::vector<bool> occupied;
+			std::size_t rows = grid.rows.size();
+			auto occupy = [&](const GridItem& item) {
+				rows = std::max(rows, item.row + item.row_span);
+				occupied.resize(rows * columns, false);
+				for (std::size_t r = item.row; r < item.row + item.row_span; ++r) {
+					for (std::size_t c = item.column; c < item.column + item.column_span; ++c) {
+						occupied[r * columns + c] = true;
+					}
+				}
+				items.push_back(item);
+			};
+			for (const auto& child : sorted_elements) {
+				LayoutNode* elem = child.node;
+				if (!elem || !elem->isVisible() || !elem->m_gridcell.placed || elem->layoutStyle() == LayoutStyle::Free) {
+					continue;
+				}
+				const auto& cell = elem->m_gridcell;
+				std::size_t column = std::min<std::size_t>(cell.column, columns - 1);
+				std::size_t column_span = std::min<std::size_t>(cell.column_span, columns - column);
+				occupy({ elem, cell.row, column, cell.row_span, column_span });
+			}
+			std::size_t next_cell = 0;
+			for (const auto& child : sorted_elements) {
+				LayoutNode* elem = child.node;
+				if (!elem || !elem->isVisible()) {
+					continue;
+				}
+				if (elem->layoutStyle() == LayoutStyle::Free) {
+					elem->update(far_away);
+					continue;
+				}
+				if (elem->m_gridcell.placed) {
+					continue;
+				}
+				while (next_cell < occupied.size() && occupied[next_cell]) {
+					++next_cell;
+				}
+				occupy({ elem, next_cell / columns, next_cell % columns, 1, 1 });
+			}
+
+			// size the columns
+			std::vector<float>& column_sizes = grid.column_sizes;
+			column_sizes.assign(columns, 0.0f);
+			float fractions = 0.0f;
+			for (std::size_t c = 0; c < columns; ++c) {
+				GridTrack track = columnTrack(c);
+				if (track.type == GridTrack::Fixed) {
+					column_sizes[c] = track.value;
+				} else if (track.type == GridTrack::Fraction) {
+					fractions += track.value;
+				}
+			}
+			for (const auto& item : items) {
+				if (item.column_span == 1 && columnTrack(item.column).type == GridTrack::Auto) {
+					float natural = measureNatural(*item.node, inner_width).x;
+					column_sizes[item.column] = std::max(column_sizes[item.column], natural + 2.0f * item.node->margin());
+				}
+			}
+			float used = (float)(columns - 1) * gap;
+			for (std::size_t c = 0; c < columns; ++c) {
+				if (columnTrack(c).type != GridTrack::Fraction) {
+					used += column_sizes[c];
+				}
+			}
+			if (fractions > 0.0f) {
+				float free = std::max(inner_width - used, 0.0f);
+				for (std::size_t c = 0; c < columns; ++c) {
+					GridTrack track = columnTrack(c);
+					if (track.type == GridTrack::Fraction) {
+						column_sizes[c] = free * track.value / fractions;
+					}
+				}
+			}
+
+			std::vector<float> column_pos(columns + 1, self.padding());
+			for (std::size_t c = 0; c < columns; ++c) {
+				column_pos[c + 1] = column_pos[c] + column_sizes[c] + gap;
+			}
+
+			// lay out each child to fill the width of its cell, which does nothing
+			// for children that haven't changed and whose columns kept their size
+			for (const auto& item : items) {
+				LayoutNode& node = *item.node;
+				float width = column_pos[item.column + item.column_span] - gap - column_pos[item.column] - 2.0f * node.margin();
+				width = std::max(width, 0.0f);
+				node.m_assignedsize = width;
+				node.update(width);
+			}
+
+			// size the rows
+			std::vector<float>& row_sizes = grid.row_sizes;
+			row_sizes.assign(rows, 0.0f);
+			fractions = 0.0f;
+			for (std::size_t r = 0; r < rows; ++r) {
+				GridTrack track = rowTrack(r);
+				if (track.type == GridTrack::Fixed) {
+					row_sizes[r] = track.value;
+				} else if (track.type == GridTrack::Fraction) {
+					fractions += track.value;
+				}
+			}
+			for (const auto& item : items) {
+				if (item.row_span == 1 && rowTrack(item.row).type == GridTrack::Auto) {
+					row_sizes[item.row] = std::max(row_sizes[item.row], item.node->height() + 2.0f * item.node->margin());
+				}
+			}
+			used = rows > 0 ? (float)(rows - 1) * gap : 0.0f;
+			for (std::size_t r = 0; r < rows; ++r) {
+				if (rowTrack(r).type != GridTrack::Fraction) {
+					used += row_sizes[r];
+				}
+			}
+			if (fractions > 0.0f) {
+				float free = std::max(self.minHeight() - 2.0f * self.padding() - used, 0.0f);
+				for (std::size_t r = 0; r < rows; ++r) {
+					GridTrack track = rowTrack(r);
+					if (track.type == GridTrack::Fraction) {
+						row_sizes[r] = free * track.value / fractions;
+					}
+				}
+			}
+			// the last Auto row spanned by a taller child grows to fit it
+			for (const auto& item : items) {
+				if (item.row_span == 1) {
+					continue;
+				}
+				float spanned = (float)(item.row_span - 1) * gap;
+				for (std::size_t r = item.row; r < item.row + item.row_span; ++r) {
+					spanned += row_sizes[r];
+				}
+				float needed = item.node->height() + 2.0f * item.node->margin();
+				std::size_t last = item.row + item.row_span - 1;
+				if (needed > spanned && rowTrack(last).type == GridTrack::Auto) {
+					row_sizes[last] += needed - spanned;
+				}
+			}
+
+			std::vector<float> row_pos(rows + 1, self.padding());
+			for (std::size_t r = 0; r < rows; ++r) {
+				row_pos[r + 1] = row_pos[r] + row_sizes[r] + gap;
+			}
+
+			for (const auto& item : items) {
+				LayoutNode& node = *item.node;
+				node.place({ column_pos[item.column] + node.margin(), row_pos[item.row] + node.margin() });
+			}
+
+			contentsize = Float2(
+				column_pos[columns] - gap + self.padding(),
+				(rows > 0 ? row_pos[rows] - gap : self.padding()) + self.padding()
+			);
+		}
+
+		// the natural size of a child of a Flex or Grid node, as measured when it last changed
+		Float2 measureNatural(LayoutNode& node, float inner_width) {
+			float avail = inner_width - 2.0f * node.margin();
+			LayoutNode::MeasuredSize& measured = node.m_measuredsize;
+			bool changed = node.isDirty() || node.m_subtreedirty || measured.generation != node.m_layoutgeneration;
+			if (measured.size.x >= 0.0f && !changed && std::abs(measured.width_avail - avail) <= epsilon) {
+				return measured.size;
+			}
+			if (node.m_assignedsize >= 0.0f) {
+				node.m_assignedsize = -1.0f;
+				node.m_isdirty = true;
+			}
+			node.update(avail);
+			measured.size = node.size();
+			measured.width_avail = avail;
+			measured.generation = node.m_layoutgeneration;
+			return measured.size;
+		}
+
+		// lays out, in parallel, dirty children whose available width doesn't depend
+		// on their siblings: free elements, and block elements if nothing floats
+		void updateIndependentChildren() {
+			ThreadPool* pool = layout_pool.get();
+			if (!pool) {
+				return;
+			}
+
+			struct Job {
+				LayoutNode* node;
+				float width_avail;
+				std::vector<LayoutNode*> resized;
+			};
+			std::vector<Job> jobs;
+
+			bool has_floats = false;
+			for (const auto& child : sorted_elements) {
+				LayoutNode* elem = child.node;
+				if (elem && elem->isVisible() && (elem->layoutStyle() == LayoutStyle::FloatLeft || elem->layoutStyle() == LayoutStyle::FloatRight)) {
+					has_floats = true;
+					break;
+				}
+			}
+
+			for (const auto& child : sorted_elements) {
+				LayoutNode* elem = child.node;
+				if (!elem || !elem->isVisible() || !(elem->isDirty() || elem->m_subtreedirty)) {
+					continue;
+				}
+				if (elem->layoutStyle() == LayoutStyle::Free) {
+					jobs.push_back({ elem, far_away, {} });
+				} else if (isBlockLike(elem->layoutStyle()) && !has_floats) {
+					// the same width arrangeBlock will give it on the first pass
+					jobs.push_back({ elem, width_avail - 2.0f * self.padding() - 2.0f * elem->margin(), {} });
+				}
+			}
+			if (jobs.size() < 2) {
+				return;
+			}
+
+			ThreadPool::TaskGroup group;
+			for (auto& job : jobs) {
+				pool->run(group, [&job] {
+					auto outer = deferred_resizes;
+					auto outer_root = job_root;
+					deferred_resizes = &job.resized;
+					job_root = job.node;
+					try {
+						job.node->update(job.width_avail);
+					} catch (...) {
+						deferred_resizes = outer;
+						job_root = outer_root;
+						throw;
+					}
+					deferred_resizes = outer;
+					job_root = outer_root;
+				});
+			}
+			pool->wait(group);
+
+			// continue the trails of subtrees left unfinished by the layout budget
+			for (const auto& job : jobs) {
+				if (job.node->isDirty() || job.node->m_subtreedirty) {
+					job.node->makeAncestorsSubtreeDirty();
+				}
+			}
+
+			// callbacks run in the same order they would have without threads,
+			// or are passed on if this is itself being laid out on a worker
+			for (const auto& job : jobs) {
+				for (LayoutNode* elem : job.resized) {
+					if (deferred_resizes) {
+						deferred_resizes->push_back(elem);
+					} else {
+						elem->onResize();
+					}
+				}
+			}
+		}
+
+		void arrangeBlock(LayoutNode* node) {
+			LayoutNode& elem = *node;
+
+			while (nextWiderLine()) {
+
+			}
+
+			elem.place({ self.padding() + elem.margin(), next_ypos + elem.margin() });
+			elem.update(right_edge - left_edge - 2.0f * elem.margin());
+			next_ypos = elem.top() + elem.height() + elem.margin();
+			fitContents(elem);
+			newLine();
+		}
+
+		// arranges an inline element adjacent to previous inline elements,
+		// flowing around floating elements.
+		// returns true if the available width was exceeded and the element
+		// broke onto a new line
+		bool arrangeInline(LayoutNode* node) {
+			LayoutNode& elem = *node;
+			bool broke_line = false;
+			do {
+				// position the element
+				elem.place({ xpos + elem.margin(), ypos + elem.margin() });
+				elem.update(right_edge - xpos - 2.0f * elem.margin() - self.padding());
+
+				if (elem.left() + elem.width() + elem.margin() > right_edge) {
+					broke_line = true;
+					// if it goes past the edge
+					if (emptyline) {
+						// if it's the only inline element on the line, find the next wider line
+						if (!nextWiderLine()) {
+							// if one doesn't exist
+							break;
+						}
+					} else {
+						// if other inline elements are on the line
+						newLine();
+					}
+				} else {
+					// if the element fits
+					break;
+				}
+
+			} while (true);
+
+			xpos = elem.left() + elem.width() + elem.margin();
+			next_ypos = std::max(next_ypos, elem.top() + elem.height() + elem.margin());
+			fitContents(elem);
+			emptyline = false;
+			return broke_line;
+		}
+
+		// arranges an inline box of a run of text like an inline node.
+		// returns true if it broke onto a new line
+		bool arrangeBox(InlineBox& box) {
+			bool broke_line = false;
+			while (true) {
+				box.pos = { xpos, ypos };
+				if (box.pos.x + box.width > right_edge) {
+					broke_line = true;
+					if (emptyline) {
+						// if it's the only box on the line, find the next wider line
+						if (!nextWiderLine()) {
+							break;
+						}
+					} else {
+						newLine();
+					}
+				} else {
+					break;
+				}
+			}
+
+			xpos = box.pos.x + box.width + box.advance;
+			next_ypos = std::max(next_ypos, box.pos.y + box.height);
+			contentsize = Float2(
+				std::max(contentsize.x, box.pos.x + box.width + self.padding()),
+				std::max(contentsize.y, box.pos.y + box.height + self.padding())
+			);
+			emptyline = false;
+			return broke_line;
+		}
+
+		// arranges a left-floating element to the right of the left edge
+		// and any current left-floating elements.
+		// returns true if the available width was exceeded and the element
+		// broke onto a new line
+		bool arrangeFloatingLeft(LayoutNode* node) {
+			if (!emptyline) {
+				newLine();
+			}
+			LayoutNode& elem = *node;
+			bool broke_line = false;
+			do {
+				elem.place({ left_edge + elem.margin(), ypos + elem.margin() });
+				elem.update(right_edge - left_edge - 2.0f * elem.margin());
+				if (elem.left() + elem.width() + elem.padding() > right_edge) {
+					broke_line = true;
+					// if the element doesn't fit
+					if (!nextWiderLine()) {
+						// if a wider line can't be found
+						break;
+					}
+				} else {
+					// if the element fits
+					break;
+				}
+			} while (true);
+			floatingleft.add(elem.top() + elem.height() + elem.margin(), elem.left() + elem.width() + elem.margin());
+			left_edge = getLeftEdge();
+			xpos = left_edge;
+			fitContents(elem);
+			return broke_line;
+		}
+
+		// arranges a right-floating element left of the right edge and any
+		// other current right-floating elements.
+		// return true if the available width was exceeded and the element
+		// broke onto a new line
+		bool arrangeFloatingRight(LayoutNode* node) {
+			LayoutNode& elem = *node;
+			bool broke_line = false;
+			do {
+				float avail = right_edge - left_edge - elem.margin() * 2.0f;
+				elem.update(avail);
+				if (elem.width() > avail) {
+					broke_line = true;
+					if (!nextWiderLine()) {
+						// if a wider line can't be found
+						break;
+					}
+				} else {
+					break;
+				}
+			} while (true);
+
+			elem.place({ right_edge - elem.width() - elem.margin(), ypos + elem.margin() });
+			floatingright.add(elem.top() + elem.height() + elem.margin(), elem.left() - elem.margin());
+			right_edge = getRightEdge();
+			fitContents(elem);
+			return broke_line;
+		}
+
+		// adjusts `contentsize` to include the element
+		void fitContents(const LayoutNode& elem) {
+			contentsize = Float2(
+				std::max(contentsize.x, elem.left() + elem.width() + elem.margin() + self.padding()),
+				std::max(contentsize.y, elem.top() + elem.height() + elem.margin() + self.padding())
+			);
+		}
+
+		bool nextWiderLine() {
+			// if floating left elements, find next bottom edge of floating left and make newline there, return true
+			// else return false
+
+			if (!floatingleft.empty() || !floatingright.empty()) {
+				float next_y = std::min(floatingleft.nextBottom(), floatingright.nextBottom());
+
+				next_ypos = std::max(next_y, next_ypos);
+				newLine();
+				return true;
+			}
+
+			return false;
+		}
+
+		void newLine() {
+			ypos = next_ypos;
+
+			floatingleft.expireAbove(ypos);
+			floatingright.expireAbove(ypos);
+
+			left_edge = getLeftEdge();
+			right_edge = getRightEdge();
+			xpos = left_edge;
+			emptyline = true;
+		}
+
+		float tab(unsigned charsize, float left) {
+			float tab_size = 50.0f * (float)charsize / 15.0f;
+			float nu_xpos = std::floor(((xpos - left) / tab_size) + 1.0f) * tab_size;
+			float diff = nu_xpos - (xpos - left);
+			xpos = nu_xpos + left;
+			return diff;
+		}
+
+		float getLeftEdge() const {
+			// Assumption: all elements in `floatingleft` pass through ypos
+			float extent = self.padding();
+			if (!floatingleft.empty()) {
+				extent = std::max(extent, *floatingleft.extents.rbegin());
+			}
+			return extent;
+		}
+
+		float getRightEdge() const {
+			// Assumption: all elements in `floatingright` pass through ypos
+			float extent = width_avail - self.padding();
+			if (!floatingright.empty()) {
+				extent = std::min(extent, *floatingright.extents.begin());
+			}
+			return extent;
+		}
+	};
+
+	Float2 LayoutNode::arrangeChildren(float width_avail) {
+		if (m_layoutsequence.empty()) {
+			return { padding(), padding() };
+		}
+
+		Float2 contentsize;
+		if (restoreCachedLayout(width_avail, contentsize)) {
+			return contentsize;
+		}
+
+		contentsize = layoutChildren(width_avail);
+
+		cacheLayout(width_avail, contentsize);
+
+		return contentsize;
+	}
+
+	Float2 LayoutNode::layoutChildren(float width_avail) {
+		if (m_layoutsequence.empty()) {
+			return { padding(), padding() };
+		}
+
+		LayoutData layout(*this, width_avail);
+
+		layout.layoutElements();
+
+		return layout.contentsize;
+	}
+
+	bool LayoutNode::restoreCachedLayout(float width_avail, Float2& contentsize) {
+		auto entry = std::find_if(m_layoutcache.begin(), m_layoutcache.end(), [&](const CachedLayout& cached) {
+			return cached.generation == m_layoutgeneration && std::abs(cached.width_avail - width_avail) <= epsilon;
+		});
+		if (entry == m_layoutcache.end()) {
+			return false;
+		}
+		if (layoutStyle() == LayoutStyle::Flex || layoutStyle() == LayoutStyle::Grid) {
+			// sizes given to children are restored with them
+			std::size_t i = 0;
+			for (const auto& item : m_layoutsequence) {
+				if (item.node && i < entry->children.size()) {
+					const CachedChildLayout& cached = entry->children[i++];
+					if (item.node == cached.child && std::abs(item.node->m_assignedsize - cached.assignedsize) > epsilon) {
+						item.node->m_assignedsize = cached.assignedsize;
+						item.node->m_isdirty = true;
+					}
+				}
+			}
+		}
+
+		// bring children back to the sizes they had, which is cheap for
+		// children that are themselves clean or cached
+		std::size_t i = 0;
+		for (const auto& item : m_layoutsequence) {
+			LayoutNode* child = item.node;
+			if (!child) {
+				continue;
+			}
+			if (i >= entry->children.size()) {
+				return false;
+			}
+			const CachedChildLayout& cached = entry->children[i++];
+			if (child != cached.child) {
+				return false;
+			}
+			if (child->isVisible() != cached.laid_out) {
+				return false;
+			}
+			if (!cached.laid_out) {
+				continue;
+			}
+			if (child->update(cached.width_avail)) {
+				return false;
+			}
+			Float2 outersize = child->size() + Float2(2.0f * child->margin(), 2.0f * child->margin());
+			if (std::abs(outersize.x - cached.outersize.x) + std::abs(outersize.y - cached.outersize.y) > epsilon) {
+				return false;
+			}
+		}
+		if (i != entry->children.size()) {
+			return false;
+		}
+
+		i = 0;
+		for (const auto& item : m_layoutsequence) {
+			LayoutNode* child = item.node;
+			if (!child) {
+				continue;
+			}
+			const CachedChildLayout& cached = entry->children[i++];
+			if (cached.laid_out && child->layoutStyle() != LayoutStyle::Free) {
+				child->place(cached.pos);
+			}
+		}
+		contentsize = entry->contentsize;
+
+		// keep the most recently used layout at the back
+		std::rotate(entry, entry + 1, m_layoutcache.end());
+		return true;
+	}
+
+	void LayoutNode::cacheLayout(float width_avail, Float2 contentsize) {
+		m_layoutcache.erase(
+			std::remove_if(m_layoutcache.begin(), m_layoutcache.end(), [&](const CachedLayout& cached) {
+				return cached.generation != m_layoutgeneration || std::abs(cached.width_avail - width_avail) <= epsilon;
+			}),
+			m_layoutcache.end()
+		);
+		if (m_layoutcache.size() >= layout_cache_size) {
+			m_layoutcache.erase(m_layoutcache.begin());
+		}
+
+		CachedLayout entry;
+		entry.width_avail = width_avail;
+		entry.generation = m_layoutgeneration;
+		entry.contentsize = contentsize;
+		for (const auto& item : m_layoutsequence) {
+			if (LayoutNode* child = item.node) {
+				Float2 outersize = child->size() + Float2(2.0f * child->margin(), 2.0f * child->margin());
+				entry.children.push_back({ child, child->isVisible(), child->pos(), outersize, child->m_widthavail, child->m_assignedsize });
+			}
+		}
+		m_layoutcache.push_back(std::move(entry));
+	}
+
+	GridTrack::GridTrack(GridTrack::Type _type, float _value)
+		: type(_type), value(_value) {
+
+	}
+
+	LayoutNode::WhiteSpace::WhiteSpace(LayoutNode::WhiteSpace::Type _type, unsigned _charsize, std::size_t _run)
+		: type(_type), charsize(_charsize), run(_run) {
+
+	}
+
+} // namespace ui
@@ -0,0 +1,152 @@
+#include "GUI/Paragraph.hpp"
+#include "GUI/Glyphs.hpp"
+
+#include <algorithm>
+#include <cmath>
+
+namespace ui {
+
+	Paragraph::Paragraph(LayoutStyle style)
+		: Element(style),
+		m_geometrydirty(false) {
+		setBorderColor(sf::Color(0));
+		setBackgroundColor(sf::Color(0));
+	}
+
+	void Paragraph::write(const std::wstring& text, sf::Font& font, sf::Color color, unsigned charsize, TextStyle style) {
+		bool bold = hasStyle(style, TextStyle::Bold);
+		float space_width = font.getGlyph(L' ', charsize, bold).advance;
+
+		Run run { &font, color, charsize, style, font.getLineSpacing(charsize), {}, m_words.size(), 0 };
+		bool inword = false;
+		wchar_t prev = 0;
+
+		auto endRun = [&, this]() {
+			if (run.word_count > 0) {
+				m_runs.push_back(run);
+				m_layoutsequence.push_back({ nullptr, WhiteSpace(WhiteSpace::Text, charsize, m_runs.size() - 1) });
+			}
+			run.text.clear();
+			run.first_word = m_words.size();
+			run.word_count = 0;
+			inword = false;
+		};
+
+		for (const wchar_t& ch : text) {
+			if (ch == L'\n') {
+				endRun();
+				m_layoutsequence.push_back({ nullptr, WhiteSpace(WhiteSpace::LineBreak, charsize) });
+			} else if (ch == L'\t') {
+				endRun();
+				m_layoutsequence.push_back({ nullptr, WhiteSpace(WhiteSpace::Tab, 15u) });
+			} else if (ch == L' ') {
+				if (inword) {
+					m_boxes.back().advance = space_width;
+					run.text += ch;
+					inword = false;
+				}
+			} else {
+				if (!inword) {
+					m_words.push_back({ run.text.size(), 0 });
+					m_boxes.push_back({ { 0.0f, 0.0f }, 0.0f, run.height, 0.0f });
+					++run.word_count;
+					inword = true;
+					prev = 0;
+				}
+				m_boxes.back().width += font.getKerning(prev, ch, charsize) + font.getGlyph(ch, charsize, bold).advance;
+				++m_words.back().length;
+				run.text += ch;
+				prev = ch;
+			}
+		}
+		endRun();
+
+		childrenChanged();
+	}
+
+	void Paragraph::clear() {
+		m_runs.clear();
+		m_words.clear();
+		m_boxes.clear();
+		m_glyphs.clear();
+		m_geometrydirty = false;
+		Element::clear();
+	}
+
+	void Paragraph::record(DrawList& list, sf::RenderStates states) {
+		Element::record(list, states);
+		if (m_geometrydirty) {
+			updateGeometry();
+		}
+		for (const auto& batch : m_glyphs) {
+			if (batch.vertices.getVertexCount() > 0) {
+				states.texture = batch.texture;
+				list.addTriangles(&batch.vertices[0], batch.vertices.getVertexCount(), states);
+			}
+		}
+	}
+
+	Float2 Paragraph::arrangeChildren(float width_avail) {
+		m_geometrydirty = true;
+		return layoutChildren(width_avail);
+	}
+
+	InlineBox* Paragraph::inlineBoxes(std::size_t run, std::size_t& count) {
+		count = m_runs[run].word_count;
+		return m_boxes.data() + m_runs[run].first_word;
+	}
+
+	void Paragraph::updateGeometry() {
+		for (auto& batch : m_glyphs) {
+			batch.vertices.clear();
+		}
+
+		for (const auto& run : m_runs) {
+			const sf::Texture* texture = &run.font->getTexture(run.charsize);
+			auto batch = std::find_if(m_glyphs.begin(), m_glyphs.end(), [&](const GlyphBatch& b) {
+				return b.texture == texture;
+			});
+			if (batch == m_glyphs.end()) {
+				m_glyphs.push_back({ texture, sf::VertexArray(sf::Triangles) });
+				batch = m_glyphs.end() - 1;
+			}
+			sf::VertexArray& vertices = batch->vertices;
+
+			bool bold = hasStyle(run.style, TextStyle::Bold);
+			float shear = hasStyle(run.style, TextStyle::Italic) ? italic_shear : 0.0f;
+			float thickness = run.font->getUnderlineThickness(run.charsize);
+			float underline = run.font->getUnderlinePosition(run.charsize);
+			const sf::FloatRect& xbounds = run.font->getGlyph(L'x', run.charsize, bold).bounds;
+			float strikethrough = xbounds.top + xbounds.height * 0.5f;
+
+			for (std::size_t i = run.first_word; i < run.first_word + run.word_count; ++i) {
+				const Word& word = m_words[i];
+				const InlineBox& box = m_boxes[i];
+				vec2 baseline = toVec2(box.pos) + vec2(0.0f, (float)run.charsize);
+				wchar_t prev = 0;
+				for (std::size_t c = word.begin; c < word.begin + word.length; ++c) {
+					wchar_t ch = run.text[c];
+					baseline.x += run.font->getKerning(prev, ch, run.charsize);
+					const sf::Glyph& glyph = run.font->getGlyph(ch, run.charsize, bold);
+					appendGlyph(vertices, run.color, baseline, glyph, shear);
+					baseline.x += glyph.advance;
+					prev = ch;
+				}
+				// lines continue over the space to the next word on the same line
+				float right = box.pos.x + box.width;
+				if (i + 1 < run.first_word + run.word_count && m_boxes[i + 1].pos.y == box.pos.y) {
+					right = m_boxes[i + 1].pos.x;
+				}
+				if (hasStyle(run.style, TextStyle::Underlined)) {
+					appendLine(vertices, run.color, box.pos.x, right, baseline.y + underline, thickness);
+				}
+				if (hasStyle(run.style, TextStyle::StrikeThrough)) {
+					appendLine(vertices, run.color, box.pos.x, right, baseline.y + strikethrough, thickness);
+				}
+			}
+		}
+
+		m_geometrydirty = false;
+	}
+
+} // namespace ui
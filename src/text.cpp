@@ -1,4 +1,5 @@
 #include "GUI/Text.hpp"
+#include "GUI/Glyphs.hpp"
 
 namespace ui {
 
@@ -7,7 +8,9 @@ namespace ui {
 	}
 
 	Text::Text(std::wstring _text, const sf::Font& _font, sf::Color color, unsigned charsize, TextStyle style)
-		: text(_text, _font) {
+		: text(_text, _font),
+		glyphs(sf::Triangles),
+		glyphs_dirty(true) {
 		text.setFillColor(color);
 		setBorderColor(sf::Color(0));
 		setBackgroundColor(sf::Color(0));
@@ -45,6 +48,8 @@ namespace ui {
 
 	void Text::setTextColor(sf::Color color) {
 		text.setFillColor(color);
+		glyphs_dirty = true;
+		repaint();
 	}
 
 	const sf::Color& Text::getTextColor() const {
@@ -53,20 +58,37 @@ namespace ui {
 
 	void Text::setStyle(TextStyle style) {
 		text.setStyle(static_cast<uint32_t>(style));
+		glyphs_dirty = true;
+		repaint();
 	}
 
 	TextStyle Text::getStyle() const {
 		return static_cast<TextStyle>(text.getStyle());
 	}
 
-	void Text::render(sf::RenderWindow& rw) {
-		Element::render(rw);
-		rw.draw(text);
+	void Text::record(DrawList& list, sf::RenderStates states) {
+		Element::record(list, states);
+		const sf::Font* font = text.getFont();
+		if (!font) {
+			return;
+		}
+		if (glyphs_dirty) {
+			glyphs.clear();
+			appendString(glyphs, text.getString(), *font, getCharacterSize(), getStyle(), getTextColor(), text.getPosition());
+			glyphs_dirty = false;
+		}
+		if (glyphs.getVertexCount() > 0) {
+			states.texture = &font->getTexture(getCharacterSize());
+			list.addTriangles(&glyphs[0], glyphs.getVertexCount(), states);
+		}
 	}
 
 	void Text::updateSize() {
 		sf::FloatRect bounds = text.getGlobalBounds();
 		text.setPosition({ ceil((float)getCharacterSize() / 5.0f), ceil((float)getCharacterSize() / 5.0f) });
+		// every change to the string, including typing, comes through here
+		glyphs_dirty = true;
+		repaint();
 		vec2 newsize;
 		newsize.y = std::max((float)text.getCharacterSize(), bounds.height - bounds.top);
 		newsize.x = std::max((float)text.getCharacterSize(), bounds.width + bounds.left);
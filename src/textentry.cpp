@@ -56,8 +56,8 @@ namespace ui {
 
 	}
 
-	void TextEntry::render(sf::RenderWindow& renderwindow) {
-		Text::render(renderwindow);
+	void TextEntry::record(DrawList& list, sf::RenderStates states) {
+		Text::record(list, states);
 		if (typing()) {
 			updateCursorPosition();
 			sf::RectangleShape rect { vec2(cursor_width, (float)text.getCharacterSize()) };
@@ -70,7 +70,7 @@ namespace ui {
 				cursor_pos,
 				ceil((float)getCharacterSize() / 5.0f)
 			});
-			renderwindow.draw(rect);
+			list.addShape(rect, states);
 		}
 	}
 
@@ -0,0 +1,138 @@
+#include "GUI/ThreadPool.hpp"
+
+namespace ui {
+
+	namespace {
+		// index of the current thread's queue, if it is a worker of `current_pool`
+		thread_local const ThreadPool* current_pool = nullptr;
+		thread_local std::size_t current_queue = 0;
+	}
+
+	ThreadPool::TaskGroup::TaskGroup() :
+		pending(0) {
+
+	}
+
+	ThreadPool::ThreadPool(unsigned threads) :
+		queued(0),
+		stopping(false) {
+
+		for (unsigned i = 0; i <= threads; ++i) {
+			queues.push_back(std::make_unique<Queue>());
+		}
+		for (unsigned i = 0; i < threads; ++i) {
+			workers.emplace_back(&ThreadPool::workerLoop, this, i);
+		}
+	}
+
+	ThreadPool::~ThreadPool() {
+		{
+			std::lock_guard<std::mutex> lock(sleep_mutex);
+			stopping = true;
+		}
+		sleep_cv.notify_all();
+		for (auto& worker : workers) {
+			worker.join();
+		}
+	}
+
+	unsigned ThreadPool::size() const {
+		return static_cast<unsigned>(workers.size());
+	}
+
+	void ThreadPool::run(TaskGroup& group, std::function<void()> task) {
+		++group.pending;
+		{
+			// counted before being queued so that taking the task never sees
+			// the count go below zero. Taking the lock prevents a worker from
+			// missing the notification between finding no work and going to sleep
+			std::lock_guard<std::mutex> lock(sleep_mutex);
+			++queued;
+		}
+		Queue& queue = *queues[current_pool == this ? current_queue : workers.size()];
+		{
+			std::lock_guard<std::mutex> lock(queue.mutex);
+			queue.tasks.push_back({ std::move(task), &group });
+		}
+		sleep_cv.notify_one();
+	}
+
+	void ThreadPool::wait(TaskGroup& group) {
+		Task task;
+		while (group.pending > 0) {
+			if (takeTask(task)) {
+				execute(task);
+			} else {
+				std::this_thread::yield();
+			}
+		}
+		if (group.exception) {
+			std::exception_ptr e = group.exception;
+			group.exception = nullptr;
+			std::rethrow_exception(e);
+		}
+	}
+
+	bool ThreadPool::takeTask(Task& task) {
+		std::size_t own = current_pool == this ? current_queue : workers.size();
+
+		// newest first from the own queue, since its data is most likely still in cache
+		{
+			Queue& queue = *queues[own];
+			std::lock_guard<std::mutex> lock(queue.mutex);
+			if (!queue.tasks.empty()) {
+				task = std::move(queue.tasks.back());
+				queue.tasks.pop_back();
+				--queued;
+				return true;
+			}
+		}
+
+		// oldest first from the others, since those tend to be the largest
+		for (std::size_t i = 1; i < queues.size(); ++i) {
+			Queue& queue = *queues[(own + i) % queues.size()];
+			std::lock_guard<std::mutex> lock(queue.mutex);
+			if (!queue.tasks.empty()) {
+				task = std::move(queue.tasks.front());
+				queue.tasks.pop_front();
+				--queued;
+				return true;
+			}
+		}
+		return false;
+	}
+
+	void ThreadPool::execute(Task& task) {
+		TaskGroup& group = *task.group;
+		try {
+			task.function();
+		} catch (...) {
+			std::lock_guard<std::mutex> lock(group.exception_mutex);
+			if (!group.exception) {
+				group.exception = std::current_exception();
+			}
+		}
+		task.function = nullptr;
+		--group.pending;
+	}
+
+	void ThreadPool::workerLoop(std::size_t index) {
+		current_pool = this;
+		current_queue = index;
+		Task task;
+		while (true) {
+			if (takeTask(task)) {
+				execute(task);
+				continue;
+			}
+			std::unique_lock<std::mutex> lock(sleep_mutex);
+			sleep_cv.wait(lock, [this] {
+				return stopping || queued > 0;
+			});
+			if (stopping && queued == 0) {
+				return;
+			}
+		}
+	}
+
+} // namespace ui
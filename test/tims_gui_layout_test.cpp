@@ -0,0 +1,157 @@
+// Regression tests of the layout engine. Each test builds a small tree of layout
+// nodes and checks where its nodes end up. No window or display is needed.
+//
+// usage: tims-gui-layout-test
+
+#include <GUI/Layout.hpp>
+
+#include <cmath>
+#include <cstdio>
+#include <functional>
+#include <memory>
+#include <vector>
+
+namespace {
+
+	using ui::LayoutNode;
+	using ui::LayoutStyle;
+
+	int failures = 0;
+
+	void expect(bool condition, const char* what, float actual, float expected) {
+		if (!condition) {
+			std::printf("  expected %s to be %g, but it is %g\n", what, expected, actual);
+			++failures;
+		}
+	}
+
+	void expectNear(const char* what, float actual, float expected) {
+		expect(std::abs(actual - expected) <= 0.001f, what, actual, expected);
+	}
+
+	// a child's new margin is noticed even if its parent's arrangement
+	// for the same width was cached before the margin changed
+	void marginInvalidatesCachedLayout() {
+		LayoutNode root(LayoutStyle::Free);
+		LayoutNode paragraph(LayoutStyle::Block);
+		LayoutNode wide(LayoutStyle::Inline);
+		LayoutNode word(LayoutStyle::Inline);
+		root.setSize({ 100.0f, 400.0f }, true);
+		wide.setSize({ 150.0f, 10.0f }, true);
+		word.setSize({ 20.0f, 10.0f }, true);
+		root.appendChild(paragraph);
+		paragraph.appendChild(wide);
+		paragraph.appendChild(word);
+		root.layout(root.width());
+
+		root.setSize({ 120.0f, 400.0f }, true);
+		word.setMargin(5.0f);
+		root.layout(root.width());
+
+		expectNear("the word's left edge", word.left(), 5.0f);
+		expectNear("the word's top edge", word.top(), 15.0f);
+		expectNear("the paragraph's height", paragraph.height(), 30.0f);
+	}
+
+	// a layout cut short by its budget on worker threads finishes in later
+	// calls with the same geometry as a layout done all at once
+	void budgetWithThreadsConverges() {
+		auto build = [](LayoutNode& root, std::vector<std::unique_ptr<LayoutNode>>& nodes) {
+			root.setSize({ 800.0f, 600.0f }, true);
+			for (int i = 0; i < 8; ++i) {
+				nodes.emplace_back(new LayoutNode(LayoutStyle::Block));
+				LayoutNode& block = *nodes.back();
+				root.appendChild(block);
+				for (int j = 0; j < 3000; ++j) {
+					nodes.emplace_back(new LayoutNode(LayoutStyle::Inline));
+					nodes.back()->setSize({ 10.0f + (float)(j % 20), 12.0f }, true);
+					block.appendChild(*nodes.back());
+				}
+			}
+		};
+
+		LayoutNode expected_root(LayoutStyle::Free);
+		std::vector<std::unique_ptr<LayoutNode>> expected;
+		build(expected_root, expected);
+		expected_root.layout(expected_root.width());
+
+		ui::setLayoutThreads(4);
+		ui::setLayoutBudget(1000);
+		LayoutNode root(LayoutStyle::Free);
+		std::vector<std::unique_ptr<LayoutNode>> nodes;
+		build(root, nodes);
+		int layouts = 0;
+		for (; layouts < 100000 && (layouts == 0 || root.layoutPending()); ++layouts) {
+			root.layout(root.width());
+		}
+		ui::setLayoutBudget(0);
+		ui::setLayoutThreads(0);
+
+		expect(!root.layoutPending(), "layouts still pending", 1.0f, 0.0f);
+		for (std::size_t i = 0; i < nodes.size(); ++i) {
+			if (std::abs(nodes[i]->left() - expected[i]->left()) + std::abs(nodes[i]->top() - expected[i]->top()) > 0.001f) {
+				expect(false, "a node's left edge", nodes[i]->left(), expected[i]->left());
+				expect(false, "a node's top edge", nodes[i]->top(), expected[i]->top());
+				break;
+			}
+		}
+		expectNear("the first block's height", nodes[0]->height(), expected[0]->height());
+	}
+
+	// a run of words laid out by its node, as a paragraph's are
+	struct Words : LayoutNode {
+		Words(std::vector<ui::InlineBox> _boxes) : LayoutNode(LayoutStyle::Block), boxes(std::move(_boxes)) {
+			m_layoutsequence.push_back({ nullptr, WhiteSpace(WhiteSpace::Text) });
+		}
+
+		ui::Float2 arrangeChildren(float width_avail) override {
+			return layoutChildren(width_avail);
+		}
+
+		ui::InlineBox* inlineBoxes(std::size_t, std::size_t& count) override {
+			count = boxes.size();
+			return boxes.data();
+		}
+
+		std::vector<ui::InlineBox> boxes;
+	};
+
+	// the space after a word is kept between it and the next word, but
+	// doesn't count at the end of a line, whether fitting or aligning
+	void spaceAfterWordAtLineEnd() {
+		LayoutNode root(LayoutStyle::Free);
+		Words words({ { {}, 45.0f, 10.0f, 10.0f }, { {}, 45.0f, 10.0f, 10.0f } });
+		root.setSize({ 100.0f, 400.0f }, true);
+		words.setContentAlign(ui::ContentAlign::Right);
+		root.appendChild(words);
+		root.layout(root.width());
+
+		expectNear("the first word's left edge", words.boxes[0].pos.x, 0.0f);
+		expectNear("the second word's left edge", words.boxes[1].pos.x, 55.0f);
+		expectNear("the second word's top edge", words.boxes[1].pos.y, 0.0f);
+	}
+
+	struct Test {
+		const char* name;
+		std::function<void()> run;
+	};
+
+} // namespace
+
+int main() {
+	const std::vector<Test> tests = {
+		{ "margin invalidates cached layout", marginInvalidatesCachedLayout },
+		{ "budget with threads converges", budgetWithThreadsConverges },
+		{ "space after word at line end", spaceAfterWordAtLineEnd },
+	};
+
+	int failed = 0;
+	for (const auto& test : tests) {
+		int before = failures;
+		test.run();
+		bool passed = failures == before;
+		std::printf("%s %s\n", passed ? "pass" : "FAIL", test.name);
+		failed += passed ? 0 : 1;
+	}
+	return failed == 0 ? 0 : 1;
+}